@@ -0,0 +1,295 @@
+/**
+ * @file AlgebraicIdentityRules.hpp
+ * @brief Declarative rule table for the algebraic identity optimization
+ *
+ * Every algebraic identity is a single entry of the IdentityRules table:
+ * the opcode it applies to, the shape of its operands, the predicate the
+ * constant operand has to satisfy and the value the instruction simplifies to.
+ *
+ * The table is turned at compile time into an array indexed by opcode, holding
+ * one matcher per opcode in which the rules of that opcode are unrolled and
+ * specialized on their operand shape. Matching an instruction therefore costs
+ * one array lookup plus the evaluation of the (few) rules of its opcode.
+ *
+ * Constants are matched as APInt, so the rules apply both to scalar integers and
+ * to vectors of integers whose constant operand is a splat (e.g. x + zeroinitializer,
+ * x * <i32 1, i32 1, i32 1, i32 1>).
+ */
+
+#ifndef LLVM_TRANSFORMS_ALGEBRAICIDENTITYRULES_H
+#define LLVM_TRANSFORMS_ALGEBRAICIDENTITYRULES_H
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/PatternMatch.h"
+
+#include <array>
+#include <iterator>
+#include <utility>
+
+namespace llvm {
+    /**
+     * Shape of the operands the rule applies to
+     */
+    enum class OperandShape {
+        ConstantRHS,    // x op C
+        ConstantAny,    // x op C or C op x (commutative operations)
+        SameOperands    // x op x
+    };
+
+    /**
+     * Predicate the constant operand has to satisfy
+     */
+    enum class ConstantPredicate {
+        None,           // Used by the SameOperands rules
+        Zero,
+        One,
+        AllOnes
+    };
+
+    /**
+     * Value the instruction is replaced with
+     */
+    enum class IdentityResult {
+        Variable,       // The non constant operand
+        Zero,
+        One,
+        AllOnes
+    };
+
+    struct IdentityRule {
+        unsigned opCode;
+        OperandShape shape;
+        ConstantPredicate predicate;
+        IdentityResult result;
+        const char *description;    // Only used by the optimization remarks
+    };
+
+    /**
+     * The algebraic identities applied by the pass.
+     * Adding an identity only requires adding an entry here.
+     */
+    constexpr IdentityRule IdentityRules[] = {
+        {Instruction::Add,  OperandShape::ConstantAny,  ConstantPredicate::Zero,    IdentityResult::Variable, "x + 0 = x"},
+        {Instruction::Sub,  OperandShape::ConstantRHS,  ConstantPredicate::Zero,    IdentityResult::Variable, "x - 0 = x"},
+        {Instruction::Sub,  OperandShape::SameOperands, ConstantPredicate::None,    IdentityResult::Zero,     "x - x = 0"},
+        {Instruction::Mul,  OperandShape::ConstantAny,  ConstantPredicate::Zero,    IdentityResult::Zero,     "x * 0 = 0"},
+        {Instruction::Mul,  OperandShape::ConstantAny,  ConstantPredicate::One,     IdentityResult::Variable, "x * 1 = x"},
+        {Instruction::UDiv, OperandShape::ConstantRHS,  ConstantPredicate::One,     IdentityResult::Variable, "x / 1 = x"},
+        {Instruction::UDiv, OperandShape::SameOperands, ConstantPredicate::None,    IdentityResult::One,      "x / x = 1"},
+        {Instruction::SDiv, OperandShape::ConstantRHS,  ConstantPredicate::One,     IdentityResult::Variable, "x / 1 = x"},
+        {Instruction::SDiv, OperandShape::SameOperands, ConstantPredicate::None,    IdentityResult::One,      "x / x = 1"},
+        {Instruction::Shl,  OperandShape::ConstantRHS,  ConstantPredicate::Zero,    IdentityResult::Variable, "x << 0 = x"},
+        {Instruction::LShr, OperandShape::ConstantRHS,  ConstantPredicate::Zero,    IdentityResult::Variable, "x >> 0 = x"},
+        {Instruction::AShr, OperandShape::ConstantRHS,  ConstantPredicate::Zero,    IdentityResult::Variable, "x >> 0 = x"},
+        {Instruction::And,  OperandShape::ConstantAny,  ConstantPredicate::Zero,    IdentityResult::Zero,     "x & 0 = 0"},
+        {Instruction::And,  OperandShape::ConstantAny,  ConstantPredicate::AllOnes, IdentityResult::Variable, "x & -1 = x"},
+        {Instruction::And,  OperandShape::SameOperands, ConstantPredicate::None,    IdentityResult::Variable, "x & x = x"},
+        {Instruction::Or,   OperandShape::ConstantAny,  ConstantPredicate::Zero,    IdentityResult::Variable, "x | 0 = x"},
+        {Instruction::Or,   OperandShape::ConstantAny,  ConstantPredicate::AllOnes, IdentityResult::AllOnes,  "x | -1 = -1"},
+        {Instruction::Or,   OperandShape::SameOperands, ConstantPredicate::None,    IdentityResult::Variable, "x | x = x"},
+        {Instruction::Xor,  OperandShape::ConstantAny,  ConstantPredicate::Zero,    IdentityResult::Variable, "x ^ 0 = x"},
+        {Instruction::Xor,  OperandShape::SameOperands, ConstantPredicate::None,    IdentityResult::Zero,     "x ^ x = 0"},
+    };
+
+    constexpr unsigned NumIdentityRules = std::size(IdentityRules);
+    constexpr unsigned NumBinaryOps = Instruction::BinaryOpsEnd - Instruction::BinaryOpsBegin;
+
+    constexpr bool isBinaryOpCode(unsigned opCode) {
+        return opCode >= Instruction::BinaryOpsBegin && opCode < Instruction::BinaryOpsEnd;
+    }
+
+    constexpr bool areRulesValid() {
+        for (const IdentityRule &rule : IdentityRules) {
+            if (!isBinaryOpCode(rule.opCode)) return false;
+            if ((rule.shape == OperandShape::SameOperands) != (rule.predicate == ConstantPredicate::None)) return false;
+        }
+
+        return true;
+    }
+
+    static_assert(
+        areRulesValid(),
+        "Every algebraic identity must refer to a binary operation, and only x op x rules have no constant predicate"
+    );
+
+    inline bool satisfiesPredicate(const APInt *C, ConstantPredicate predicate) {
+        switch (predicate) {
+            case ConstantPredicate::Zero:
+                return C->isZero();
+
+            case ConstantPredicate::One:
+                return C->isOne();
+
+            case ConstantPredicate::AllOnes:
+                return C->isAllOnes();
+
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * Returns the value an instruction of the given type simplifies to,
+     * once the identity has been matched. Vector types get a splat constant.
+     */
+    inline Value *getIdentityResult(IdentityResult result, Type *type, Value *variable) {
+        switch (result) {
+            case IdentityResult::Variable:
+                return variable;
+
+            case IdentityResult::Zero:
+                return Constant::getNullValue(type);
+
+            case IdentityResult::One:
+                return ConstantInt::get(type, 1);
+
+            case IdentityResult::AllOnes:
+                return Constant::getAllOnesValue(type);
+
+            default:
+                return nullptr;
+        }
+    }
+
+    /**
+     * Returns the value of a scalar integer constant or of a splat vector constant,
+     * nullptr for any other value
+     */
+    inline const APInt *getConstantOrSplat(Value *V) {
+        const APInt *C = nullptr;
+
+        return PatternMatch::match(V, PatternMatch::m_APInt(C)) ? C : nullptr;
+    }
+
+    /**
+     * Operands of the instruction being matched.
+     *
+     * The left operand is only inspected by the commutative rules when the right one
+     * is not a matching constant: it is usually another instruction, and looking at it
+     * is likely to be a cache miss on large functions.
+     */
+    struct IdentityOperands {
+        Value *LHS;
+        Value *RHS;
+        const APInt *constantRHS;
+        const APInt *constantLHS = nullptr;
+        bool isLHSInspected = false;
+
+        IdentityOperands(BinaryOperator &BO)
+            : LHS(BO.getOperand(0)), RHS(BO.getOperand(1)), constantRHS(getConstantOrSplat(RHS)) {}
+
+        const APInt *getConstantLHS() {
+            if (!isLHSInspected) {
+                constantLHS = getConstantOrSplat(LHS);
+                isLHSInspected = true;
+            }
+
+            return constantLHS;
+        }
+    };
+
+    /**
+     * Matches a single rule. Shape and predicate are template constants,
+     * so each instantiation only contains the checks the rule needs.
+     */
+    template <unsigned RuleIndex>
+    inline bool matchIdentityRule(IdentityOperands &ops, Value *&variable) {
+        constexpr IdentityRule rule = IdentityRules[RuleIndex];
+
+        if constexpr (rule.shape == OperandShape::SameOperands) {
+            variable = ops.LHS;
+            return ops.LHS == ops.RHS;
+        } else {
+            if (ops.constantRHS && satisfiesPredicate(ops.constantRHS, rule.predicate)) {
+                variable = ops.LHS;
+                return true;
+            }
+
+            if constexpr (rule.shape == OperandShape::ConstantAny) {
+                const APInt *constantLHS = ops.getConstantLHS();
+
+                if (constantLHS && satisfiesPredicate(constantLHS, rule.predicate)) {
+                    variable = ops.RHS;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    }
+
+    /**
+     * Tries, in table order, the rules registered for the given opcode.
+     * The rules of the other opcodes are discarded at compile time.
+     */
+    template <unsigned OpCode, size_t... RuleIndices>
+    const IdentityRule *matchRulesOf(BinaryOperator &BO, Value *&variable, std::index_sequence<RuleIndices...>) {
+        IdentityOperands ops(BO);
+        const IdentityRule *matched = nullptr;
+
+        // The fold stops at the first matching rule
+        (void)(... || [&]() {
+            if constexpr (IdentityRules[RuleIndices].opCode == OpCode) {
+                if (matchIdentityRule<RuleIndices>(ops, variable)) {
+                    matched = &IdentityRules[RuleIndices];
+                    return true;
+                }
+            }
+
+            return false;
+        }());
+
+        return matched;
+    }
+
+    template <unsigned OpCode>
+    const IdentityRule *matchOpCodeIdentities(BinaryOperator &BO, Value *&variable) {
+        return matchRulesOf<OpCode>(BO, variable, std::make_index_sequence<NumIdentityRules>());
+    }
+
+    constexpr bool hasIdentities(unsigned opCode) {
+        for (const IdentityRule &rule : IdentityRules) {
+            if (rule.opCode == opCode) return true;
+        }
+
+        return false;
+    }
+
+    using IdentityMatcher = const IdentityRule *(*)(BinaryOperator &, Value *&);
+
+    /**
+     * Builds the opcode-indexed dispatch array at compile time.
+     * Opcodes without identities get a nullptr entry.
+     */
+    template <size_t... OpIndices>
+    constexpr std::array<IdentityMatcher, NumBinaryOps> buildIdentityDispatch(std::index_sequence<OpIndices...>) {
+        return {{
+            (hasIdentities(Instruction::BinaryOpsBegin + OpIndices) ?
+                static_cast<IdentityMatcher>(&matchOpCodeIdentities<Instruction::BinaryOpsBegin + OpIndices>) : nullptr)...
+        }};
+    }
+
+    constexpr std::array<IdentityMatcher, NumBinaryOps> IdentityDispatch =
+        buildIdentityDispatch(std::make_index_sequence<NumBinaryOps>());
+
+    /**
+     * Looks for an algebraic identity applicable to the given binary operation.
+     *
+     * The instruction is not modified and no constant is created: if an identity
+     * applies, variable is set to the non constant operand, and the simplified value
+     * can be obtained through getIdentityResult() once the rule is actually applied.
+     *
+     * @param BO The binary operation to match
+     * @param variable Output parameter holding the non constant operand
+     * @return The rule that was matched, nullptr if none applies
+     */
+    inline const IdentityRule *findAlgebraicIdentity(BinaryOperator &BO, Value *&variable) {
+        IdentityMatcher matcher = IdentityDispatch[BO.getOpcode() - Instruction::BinaryOpsBegin];
+
+        return matcher ? matcher(BO, variable) : nullptr;
+    }
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_ALGEBRAICIDENTITYRULES_H
@@ -0,0 +1,89 @@
+/**
+ * @file ConstantDivision.cpp
+ * @brief Implementation of the magic number computation for the division by constant
+ */
+
+#include "ConstantDivision.hpp"
+
+using namespace llvm;
+
+/**
+ * Computes 2^exponent / d and its remainder.
+ * The computation is performed on 2 * width + 1 bits, so that neither the
+ * power of two nor the doubled quotient and remainder can overflow.
+ */
+static void divideExactPower(unsigned exponent, const APInt &d, APInt &quotient, APInt &remainder) {
+    unsigned wideWidth = 2 * d.getBitWidth() + 1;
+
+    APInt::udivrem(APInt::getOneBitSet(wideWidth, exponent), d.zext(wideWidth), quotient, remainder);
+}
+
+DivisionMagic llvm::getUnsignedDivisionMagic(const APInt &d) {
+    assert(!d.isPowerOf2() && !d.isNegative() && "Divisor without an unsigned magic number");
+
+    unsigned width = d.getBitWidth();
+    unsigned floorLog2 = d.logBase2();
+
+    APInt quotient, remainder;
+    divideExactPower(width + floorLog2, d, quotient, remainder);
+
+    unsigned wideWidth = quotient.getBitWidth();
+    APInt wideD = d.zext(wideWidth);
+
+    DivisionMagic result;
+    result.shift = floorLog2;
+
+    // The error of the rounded up quotient decides if 2^(width + floorLog2)
+    // is precise enough, otherwise one more bit of magic number is needed
+    if ((wideD - remainder).ult(APInt::getOneBitSet(wideWidth, floorLog2))) {
+        result.isAdd = false;
+    } else {
+        quotient <<= 1;
+
+        if ((remainder << 1).uge(wideD)) quotient += 1;
+
+        result.isAdd = true;
+    }
+
+    // In the isAdd case the magic number has width + 1 bits: the top one is
+    // dropped and given back by adding the dividend
+    result.magic = (quotient + 1).trunc(width);
+
+    return result;
+}
+
+DivisionMagic llvm::getSignedDivisionMagic(const APInt &d) {
+    APInt absD = d.abs();
+
+    assert(!absD.isPowerOf2() && "Divisor without a signed magic number");
+
+    unsigned width = d.getBitWidth();
+    unsigned floorLog2 = absD.logBase2();
+
+    APInt quotient, remainder;
+    divideExactPower(width - 1 + floorLog2, absD, quotient, remainder);
+
+    unsigned wideWidth = quotient.getBitWidth();
+    APInt wideD = absD.zext(wideWidth);
+
+    DivisionMagic result;
+
+    if ((wideD - remainder).ult(APInt::getOneBitSet(wideWidth, floorLog2))) {
+        result.shift = floorLog2 - 1;
+        result.isAdd = false;
+    } else {
+        quotient <<= 1;
+
+        if ((remainder << 1).uge(wideD)) quotient += 1;
+
+        result.shift = floorLog2;
+        result.isAdd = true;
+    }
+
+    result.magic = (quotient + 1).trunc(width);
+
+    // Negative divisors use the opposite magic number (and subtract the dividend if isAdd)
+    if (d.isNegative()) result.magic.negate();
+
+    return result;
+}
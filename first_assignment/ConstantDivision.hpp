@@ -0,0 +1,48 @@
+/**
+ * @file ConstantDivision.hpp
+ * @brief Magic numbers for the division by invariant constants
+ *
+ * A division by a constant d is rewritten as a multiplication by a "magic"
+ * number m followed by shifts (Granlund and Montgomery, "Division by Invariant
+ * Integers using Multiplication"), using the same formulation as libdivide:
+ *
+ * - Unsigned: q = mulhu(m, n) >> s, or, when m does not fit in the bit width
+ *   (isAdd), t = mulhu(m, n), q = (((n - t) >> 1) + t) >> s
+ * - Signed: t = mulhs(m, n), t = t +- n if isAdd (the sign of d decides),
+ *   t = t >> s (arithmetic), q = t + (t < 0)
+ *
+ * where mulhu/mulhs are the high half of the double width product.
+ *
+ * Divisors whose magnitude is a power of two have no magic number: they are
+ * lowered with shifts directly.
+ */
+
+#ifndef LLVM_TRANSFORMS_CONSTANTDIVISION_H
+#define LLVM_TRANSFORMS_CONSTANTDIVISION_H
+
+#include "llvm/ADT/APInt.h"
+
+namespace llvm {
+    struct DivisionMagic {
+        APInt magic;        // Same bit width as the divisor
+        unsigned shift;
+        bool isAdd;         // The dividend has to be added back after the multiplication
+    };
+
+    /**
+     * Computes the magic number of an unsigned division by d.
+     *
+     * @param d The divisor, must not be a power of two nor have its sign bit set
+     *          (a divisor >= 2^(width - 1) is better lowered as n >= d)
+     */
+    DivisionMagic getUnsignedDivisionMagic(const APInt &d);
+
+    /**
+     * Computes the magic number of a signed division by d.
+     *
+     * @param d The divisor, its magnitude must not be a power of two
+     */
+    DivisionMagic getSignedDivisionMagic(const APInt &d);
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_CONSTANTDIVISION_H
@@ -0,0 +1,300 @@
+/**
+ * @file ConstantMultiplication.cpp
+ * @brief Implementation of the shift/add/sub synthesis for multiplications by constant
+ */
+
+#include "ConstantMultiplication.hpp"
+
+#include "llvm/ADT/DenseMap.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace llvm;
+
+unsigned llvm::getMulStepCost(MulStepKind kind) {
+    switch (kind) {
+        case MulStepKind::AddShifted:
+        case MulStepKind::SubShifted:
+            return 2;   // One shift and one add/sub
+
+        default:
+            return 1;
+    }
+}
+
+/**
+ * Appends a step to the chain, updating its cost
+ */
+static void appendStep(MulChain &chain, MulStepKind kind, unsigned amount = 0) {
+    chain.steps.push_back({kind, amount});
+    chain.cost += getMulStepCost(kind);
+}
+
+/**
+ * Computes the non zero digits of the canonical signed digit representation of C,
+ * as (position, isNegative) pairs starting from the least significant one
+ */
+static SmallVector<std::pair<unsigned, bool>, 16> getCSDDigits(const APInt &C) {
+    SmallVector<std::pair<unsigned, bool>, 16> digits;
+
+    // Two extra bits are enough to hold the carries of the recoding
+    APInt n = C.zext(C.getBitWidth() + 2);
+
+    for (unsigned pos = 0; !n.isZero(); pos++) {
+        if (n[0]) {
+            // n mod 4 == 1 gives a +1 digit, n mod 4 == 3 a -1 digit,
+            // so that the next digit is always zero
+            bool isNegative = n[1];
+            digits.push_back({pos, isNegative});
+
+            if (isNegative) n += 1;
+            else n -= 1;
+        }
+
+        n.lshrInPlace(1);
+    }
+
+    return digits;
+}
+
+/**
+ * Returns the maximum number of non zero CSD digits a constant can have,
+ * if its chain costs at most budget.
+ *
+ * The CSD weight is the minimum number of non zero signed digits, so it grows at
+ * most by one with AddX/SubX (cost 1) and at most doubles with AddShifted/SubShifted
+ * (cost 2), while shifts do not change it.
+ */
+static unsigned getMaxCSDWeight(unsigned budget) {
+    unsigned prev = 1;      // Budget 0: x itself
+    unsigned current = 2;   // Budget 1: a single AddX/SubX
+
+    if (budget == 0) return prev;
+
+    for (unsigned b = 2; b <= budget; b++) {
+        unsigned next = std::max(current + 1, 2 * prev);
+        prev = current;
+        current = next;
+    }
+
+    return current;
+}
+
+std::optional<MulChain> llvm::getCSDMulChain(const APInt &C) {
+    if (C.isZero()) return std::nullopt;
+
+    unsigned width = C.getBitWidth();
+    SmallVector<std::pair<unsigned, bool>, 16> digits = getCSDDigits(C);
+
+    unsigned topPos = digits.back().first;
+
+    if (topPos >= width) return std::nullopt;
+
+    MulChain chain;
+    unsigned pos = topPos;
+
+    for (auto it = std::next(digits.rbegin()); it != digits.rend(); ++it) {
+        appendStep(chain, MulStepKind::Shl, pos - it->first);
+        appendStep(chain, it->second ? MulStepKind::SubX : MulStepKind::AddX);
+        pos = it->first;
+    }
+
+    if (pos > 0) appendStep(chain, MulStepKind::Shl, pos);
+
+    return chain;
+}
+
+namespace {
+    /**
+     * Memoized, cost-bounded search for the cheapest chain computing x * C.
+     *
+     * For every constant n reached by the search, the possible decompositions are:
+     * - n even: n = n' * 2^k, with k the number of trailing zeros
+     * - n odd:  n = n' + 1, n = n' - 1, n = n' * (2^k + 1), n = n' * (2^k - 1)
+     *
+     * The chains end at n = 1, which costs nothing (t = x). n' is not always
+     * smaller than n (n = n' - 1 gives n' = n + 1), but every step costs at least
+     * one and the decomposition is only explored with the budget left after it, so
+     * the budget strictly decreases along the recursion and the search terminates.
+     *
+     * The search is a branch and bound: solve() only looks for chains within the
+     * given budget, which keeps the explored space small (the budget is the cost
+     * limit of the pass, or the cost of the CSD chain if lower). The memo table
+     * stores, for every n, either the cost of its cheapest chain or a lower bound
+     * on it, when no chain was found within the budget.
+     */
+    class MulChainSearch {
+        private:
+            struct Decomposition {
+                MulStepKind kind = MulStepKind::Shl;
+                unsigned amount = 0;
+                APInt next;
+            };
+
+            struct MemoEntry {
+                Decomposition best;
+                unsigned cost;          // Valid only if isExact
+                unsigned lowerBound;
+                bool isExact;
+            };
+
+            DenseMap<APInt, MemoEntry> memo;
+
+            /**
+             * Tries a decomposition, updating best and bestCost if it is cheaper
+             * than the current best and fits into the budget
+             */
+            void consider(
+                Decomposition &best,
+                unsigned &bestCost,
+                unsigned budget,
+                MulStepKind kind,
+                unsigned amount,
+                const APInt &next
+            ) {
+                unsigned stepCost = getMulStepCost(kind);
+
+                // Only strictly cheaper chains are interesting
+                unsigned limit = std::min(budget, bestCost - 1);
+                if (stepCost > limit) return;
+
+                unsigned nextCost = solve(next, limit - stepCost);
+                if (nextCost == Infinite) return;
+
+                best = {kind, amount, next};
+                bestCost = nextCost + stepCost;
+            }
+
+        public:
+            static constexpr unsigned Infinite = std::numeric_limits<unsigned>::max();
+
+            /**
+             * Returns the cost of the cheapest chain computing x * n,
+             * or Infinite if it costs more than budget
+             */
+            unsigned solve(const APInt &n, unsigned budget) {
+                if (n.isOne()) return 0;
+                if (n.isZero()) return Infinite;
+
+                auto it = memo.find(n);
+
+                if (it != memo.end()) {
+                    if (it->second.isExact) return it->second.cost <= budget ? it->second.cost : Infinite;
+                    if (it->second.lowerBound > budget) return Infinite;
+                }
+
+                unsigned width = n.getBitWidth();
+                Decomposition best;
+                unsigned bestCost = Infinite;
+
+                // Constants with too many non zero digits cannot fit in the budget
+                if (getCSDDigits(n).size() > getMaxCSDWeight(budget)) {
+                    memo[n] = {best, Infinite, budget + 1, false};
+                    return Infinite;
+                }
+
+                if (!n[0]) {
+                    unsigned k = n.countTrailingZeros();
+                    consider(best, bestCost, budget, MulStepKind::Shl, k, n.lshr(k));
+                } else {
+                    consider(best, bestCost, budget, MulStepKind::AddX, 0, n - 1);
+
+                    if (!n.isAllOnes()) {
+                        consider(best, bestCost, budget, MulStepKind::SubX, 0, n + 1);
+                    }
+
+                    // Factors of the form 2^k + 1 and 2^k - 1 reuse the intermediate product
+                    for (unsigned k = 1; k < width; k++) {
+                        APInt powerOfTwo = APInt::getOneBitSet(width, k);
+                        APInt plusOne = powerOfTwo + 1;
+
+                        if (plusOne.ugt(n)) break;
+
+                        if (n.urem(plusOne).isZero()) {
+                            consider(best, bestCost, budget, MulStepKind::AddShifted, k, n.udiv(plusOne));
+                        }
+
+                        APInt minusOne = powerOfTwo - 1;
+
+                        if (k > 1 && n.urem(minusOne).isZero()) {
+                            consider(best, bestCost, budget, MulStepKind::SubShifted, k, n.udiv(minusOne));
+                        }
+                    }
+                }
+
+                if (bestCost != Infinite) {
+                    memo[n] = {best, bestCost, bestCost, true};
+                } else {
+                    memo[n] = {best, Infinite, budget + 1, false};
+                }
+
+                return bestCost;
+            }
+
+            /**
+             * Rebuilds the chain found by solve() for n.
+             * The steps are collected from the last one and then reversed.
+             */
+            MulChain getChain(const APInt &n) {
+                MulChain chain;
+                APInt current = n;
+
+                while (!current.isOne()) {
+                    const Decomposition &step = memo.find(current)->second.best;
+
+                    appendStep(chain, step.kind, step.amount);
+                    current = step.next;
+                }
+
+                std::reverse(chain.steps.begin(), chain.steps.end());
+
+                return chain;
+            }
+    };
+} // namespace
+
+std::optional<MulChain> llvm::findMulChain(const APInt &C, unsigned costLimit) {
+    if (C.isZero()) return std::nullopt;
+
+    std::optional<MulChain> best = getCSDMulChain(C);
+
+    // x * C = -(x * -C): useful for negative constants, e.g. x * -3 = 0 - ((x << 1) + x)
+    APInt negated = -C;
+    unsigned negCost = getMulStepCost(MulStepKind::Neg);
+
+    if (std::optional<MulChain> negatedCSD = getCSDMulChain(negated)) {
+        appendStep(*negatedCSD, MulStepKind::Neg);
+
+        if (!best || negatedCSD->cost < best->cost) best = negatedCSD;
+    }
+
+    // Only happens for C = 1, nothing to search for
+    if (best && best->cost == 0) return best;
+
+    // The search only looks for chains cheaper than the CSD one
+    unsigned budget = best ? std::min(costLimit, best->cost - 1) : costLimit;
+
+    // Equal constants are reached with the same bit width, so one memo table can serve both searches
+    MulChainSearch search;
+
+    unsigned cost = search.solve(C, budget);
+
+    if (cost != MulChainSearch::Infinite) {
+        best = search.getChain(C);
+        budget = cost - 1;
+    }
+
+    if (budget >= negCost) {
+        unsigned negatedCost = search.solve(negated, budget - negCost);
+
+        if (negatedCost != MulChainSearch::Infinite) {
+            best = search.getChain(negated);
+            appendStep(*best, MulStepKind::Neg);
+        }
+    }
+
+    if (!best || best->cost > costLimit) return std::nullopt;
+
+    return best;
+}
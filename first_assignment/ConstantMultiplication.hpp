@@ -0,0 +1,82 @@
+/**
+ * @file ConstantMultiplication.hpp
+ * @brief Synthesis of shift/add/sub sequences for multiplications by constant
+ *
+ * A multiplication x * C is rewritten as a chain of steps applied to an
+ * accumulator t, which starts as t = x. Every step either shifts t, adds or
+ * subtracts x to it, or combines t with a shifted copy of itself, so that the
+ * intermediate products are reused (e.g. x * 45 = ((x << 2) + x) * 9 =
+ * (t << 3) + t with t = (x << 2) + x).
+ *
+ * Two strategies are available:
+ * - Canonical signed digit (CSD) recoding, which never uses more non zero
+ *   digits than the binary representation and gives a quick upper bound
+ * - A Bernstein-style search, which explores the decompositions
+ *   C = 2^k * C', C = C' +- 1 and C = C' * (2^k +- 1) and keeps the cheapest one
+ *
+ * Constants are handled as APInt, so every integer width is supported and the
+ * arithmetic is performed modulo 2^width, exactly like the multiplication.
+ */
+
+#ifndef LLVM_TRANSFORMS_CONSTANTMULTIPLICATION_H
+#define LLVM_TRANSFORMS_CONSTANTMULTIPLICATION_H
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <optional>
+
+namespace llvm {
+    enum class MulStepKind {
+        Shl,            // t = t << amount
+        AddX,           // t = t + x
+        SubX,           // t = t - x
+        AddShifted,     // t = (t << amount) + t
+        SubShifted,     // t = (t << amount) - t
+        Neg             // t = 0 - t
+    };
+
+    struct MulStep {
+        MulStepKind kind;
+        unsigned amount;
+    };
+
+    /**
+     * Sequence of steps computing x * C, and the number of
+     * instructions needed to emit it
+     */
+    struct MulChain {
+        SmallVector<MulStep, 8> steps;
+        unsigned cost = 0;
+    };
+
+    /**
+     * Number of instructions emitted for a step
+     */
+    unsigned getMulStepCost(MulStepKind kind);
+
+    /**
+     * Builds the chain corresponding to the canonical signed digit
+     * representation of C (Horner form, starting from the most significant digit).
+     *
+     * Returns std::nullopt if C is zero or if its representation needs a digit
+     * beyond the bit width (e.g. 2^width - 1 = 2^width - 2^0), since shifts by
+     * the bit width are not allowed.
+     */
+    std::optional<MulChain> getCSDMulChain(const APInt &C);
+
+    /**
+     * Looks for the cheapest chain computing x * C.
+     *
+     * The result of the search is compared with the CSD chain, and the cheapest
+     * of the two is returned, provided that its cost does not exceed costLimit.
+     * Negative constants are also tried as -(x * -C).
+     *
+     * @param C The constant multiplier, must not be zero
+     * @param costLimit Maximum number of instructions of the returned chain
+     * @return The chain, or std::nullopt if none respects the cost limit
+     */
+    std::optional<MulChain> findMulChain(const APInt &C, unsigned costLimit);
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_CONSTANTMULTIPLICATION_H
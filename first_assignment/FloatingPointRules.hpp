@@ -0,0 +1,220 @@
+/**
+ * @file FloatingPointRules.hpp
+ * @brief Rule table for the floating point identities
+ *
+ * Floating point arithmetic is not a field: most of the integer identities do not
+ * hold in IEEE 754 because of NaNs, infinities and signed zeros (e.g. x + 0.0 is
+ * -0.0 + 0.0 = 0.0 for x = -0.0, x * 0.0 is NaN for x = inf). Every rule therefore
+ * lists the fast-math flags the instruction must carry for the identity to be
+ * valid, and the rules without flags are exact for every input.
+ *
+ * The rules reuse the operand shapes and results of the integer identities (see
+ * AlgebraicIdentityRules.hpp). There are only a few floating point opcodes, so the
+ * table is scanned linearly instead of being turned into a dispatch array.
+ *
+ * Constants are matched as APFloat, so the rules also apply to vectors whose
+ * constant operand is a splat.
+ */
+
+#ifndef LLVM_TRANSFORMS_FLOATINGPOINTRULES_H
+#define LLVM_TRANSFORMS_FLOATINGPOINTRULES_H
+
+#include "AlgebraicIdentityRules.hpp"
+
+#include "llvm/ADT/APFloat.h"
+#include "llvm/IR/Operator.h"
+
+namespace llvm {
+    /**
+     * Predicate the floating point constant operand has to satisfy
+     */
+    enum class FPConstantPredicate {
+        None,           // Used by the SameOperands rules
+        PosZero,        // +0.0
+        NegZero,        // -0.0
+        AnyZero,        // +0.0 or -0.0
+        One             // 1.0
+    };
+
+    /**
+     * Fast-math flags a rule requires, as a bit mask combined with operator|
+     */
+    enum class FPFlagRequirement : unsigned {
+        NoFlags         = 0,
+        NoNaNs          = 1 << 0,   // nnan
+        NoInfs          = 1 << 1,   // ninf
+        NoSignedZeros   = 1 << 2,   // nsz
+        AllowReciprocal = 1 << 3,   // arcp
+        AllowReassoc    = 1 << 4    // reassoc
+    };
+
+    constexpr FPFlagRequirement operator|(FPFlagRequirement a, FPFlagRequirement b) {
+        return static_cast<FPFlagRequirement>(static_cast<unsigned>(a) | static_cast<unsigned>(b));
+    }
+
+    /**
+     * Returns true if the mask contains the flag
+     */
+    constexpr bool requiresFlag(FPFlagRequirement mask, FPFlagRequirement flag) {
+        return (static_cast<unsigned>(mask) & static_cast<unsigned>(flag)) != 0;
+    }
+
+    struct FPIdentityRule {
+        unsigned opCode;
+        OperandShape shape;
+        FPConstantPredicate predicate;
+        IdentityResult result;
+        FPFlagRequirement requiredFlags;
+        const char *description;    // Only used by the optimization remarks
+    };
+
+    /**
+     * The floating point identities applied by the pass.
+     * Adding an identity only requires adding an entry here.
+     */
+    constexpr FPIdentityRule FPIdentityRules[] = {
+        {Instruction::FAdd, OperandShape::ConstantAny,  FPConstantPredicate::NegZero, IdentityResult::Variable, FPFlagRequirement::NoFlags,                                   "x + -0.0 = x"},
+        {Instruction::FAdd, OperandShape::ConstantAny,  FPConstantPredicate::PosZero, IdentityResult::Variable, FPFlagRequirement::NoSignedZeros,                             "x + 0.0 = x"},
+        {Instruction::FSub, OperandShape::ConstantRHS,  FPConstantPredicate::PosZero, IdentityResult::Variable, FPFlagRequirement::NoFlags,                                   "x - 0.0 = x"},
+        {Instruction::FSub, OperandShape::ConstantRHS,  FPConstantPredicate::NegZero, IdentityResult::Variable, FPFlagRequirement::NoSignedZeros,                             "x - -0.0 = x"},
+        {Instruction::FSub, OperandShape::SameOperands, FPConstantPredicate::None,    IdentityResult::Zero,     FPFlagRequirement::NoNaNs,                                    "x - x = 0.0"},
+        {Instruction::FMul, OperandShape::ConstantAny,  FPConstantPredicate::One,     IdentityResult::Variable, FPFlagRequirement::NoFlags,                                   "x * 1.0 = x"},
+        {Instruction::FMul, OperandShape::ConstantAny,  FPConstantPredicate::AnyZero, IdentityResult::Zero,     FPFlagRequirement::NoNaNs | FPFlagRequirement::NoSignedZeros, "x * 0.0 = 0.0"},
+        {Instruction::FDiv, OperandShape::ConstantRHS,  FPConstantPredicate::One,     IdentityResult::Variable, FPFlagRequirement::NoFlags,                                   "x / 1.0 = x"},
+        {Instruction::FDiv, OperandShape::SameOperands, FPConstantPredicate::None,    IdentityResult::One,      FPFlagRequirement::NoNaNs,                                    "x / x = 1.0"},
+    };
+
+    constexpr bool areFPRulesValid() {
+        for (const FPIdentityRule &rule : FPIdentityRules) {
+            if (
+                rule.opCode != Instruction::FAdd && rule.opCode != Instruction::FSub &&
+                rule.opCode != Instruction::FMul && rule.opCode != Instruction::FDiv &&
+                rule.opCode != Instruction::FRem
+            ) {
+                return false;
+            }
+
+            if ((rule.shape == OperandShape::SameOperands) != (rule.predicate == FPConstantPredicate::None)) return false;
+            if (rule.result == IdentityResult::AllOnes) return false;
+        }
+
+        return true;
+    }
+
+    static_assert(
+        areFPRulesValid(),
+        "Every floating point identity must refer to a floating point operation, only x op x rules have no "
+        "constant predicate and no floating point identity can result in all ones"
+    );
+
+    /**
+     * Returns true if the instruction carries all the fast-math flags in the mask
+     */
+    inline bool hasRequiredFlags(const Instruction &inst, FPFlagRequirement requiredFlags) {
+        if (requiredFlags == FPFlagRequirement::NoFlags) return true;
+        if (!isa<FPMathOperator>(inst)) return false;
+
+        FastMathFlags flags = inst.getFastMathFlags();
+
+        return (!requiresFlag(requiredFlags, FPFlagRequirement::NoNaNs) || flags.noNaNs()) &&
+            (!requiresFlag(requiredFlags, FPFlagRequirement::NoInfs) || flags.noInfs()) &&
+            (!requiresFlag(requiredFlags, FPFlagRequirement::NoSignedZeros) || flags.noSignedZeros()) &&
+            (!requiresFlag(requiredFlags, FPFlagRequirement::AllowReciprocal) || flags.allowReciprocal()) &&
+            (!requiresFlag(requiredFlags, FPFlagRequirement::AllowReassoc) || flags.allowReassoc());
+    }
+
+    inline bool satisfiesPredicate(const APFloat *C, FPConstantPredicate predicate) {
+        switch (predicate) {
+            case FPConstantPredicate::PosZero:
+                return C->isPosZero();
+
+            case FPConstantPredicate::NegZero:
+                return C->isNegZero();
+
+            case FPConstantPredicate::AnyZero:
+                return C->isZero();
+
+            case FPConstantPredicate::One:
+                return C->isExactlyValue(1.0);
+
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * Returns the value a floating point instruction of the given type simplifies to,
+     * once the identity has been matched. Vector types get a splat constant.
+     */
+    inline Value *getFPIdentityResult(IdentityResult result, Type *type, Value *variable) {
+        switch (result) {
+            case IdentityResult::Variable:
+                return variable;
+
+            case IdentityResult::Zero:
+                return ConstantFP::get(type, 0.0);
+
+            case IdentityResult::One:
+                return ConstantFP::get(type, 1.0);
+
+            default:
+                return nullptr;
+        }
+    }
+
+    /**
+     * Returns the value of a scalar floating point constant or of a splat vector constant,
+     * nullptr for any other value
+     */
+    inline const APFloat *getFPConstantOrSplat(Value *V) {
+        const APFloat *C = nullptr;
+
+        return PatternMatch::match(V, PatternMatch::m_APFloat(C)) ? C : nullptr;
+    }
+
+    /**
+     * Looks for a floating point identity applicable to the given binary operation,
+     * among the ones allowed by its fast-math flags.
+     *
+     * As for findAlgebraicIdentity(), the instruction is not modified: if an identity
+     * applies, variable is set to the non constant operand, and the simplified value
+     * can be obtained through getFPIdentityResult().
+     *
+     * @param BO The binary operation to match
+     * @param variable Output parameter holding the non constant operand
+     * @return The rule that was matched, nullptr if none applies
+     */
+    inline const FPIdentityRule *findFPIdentity(BinaryOperator &BO, Value *&variable) {
+        Value *LHS = BO.getOperand(0);
+        Value *RHS = BO.getOperand(1);
+        const APFloat *constantRHS = getFPConstantOrSplat(RHS);
+        const APFloat *constantLHS = getFPConstantOrSplat(LHS);
+
+        for (const FPIdentityRule &rule : FPIdentityRules) {
+            if (rule.opCode != BO.getOpcode() || !hasRequiredFlags(BO, rule.requiredFlags)) continue;
+
+            if (rule.shape == OperandShape::SameOperands) {
+                if (LHS == RHS) {
+                    variable = LHS;
+                    return &rule;
+                }
+
+                continue;
+            }
+
+            if (constantRHS && satisfiesPredicate(constantRHS, rule.predicate)) {
+                variable = LHS;
+                return &rule;
+            }
+
+            if (rule.shape == OperandShape::ConstantAny && constantLHS && satisfiesPredicate(constantLHS, rule.predicate)) {
+                variable = RHS;
+                return &rule;
+            }
+        }
+
+        return nullptr;
+    }
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_FLOATINGPOINTRULES_H
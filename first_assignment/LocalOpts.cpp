@@ -2,656 +2,2378 @@
 
 using namespace llvm;
 
+#define DEBUG_TYPE "local-opts"
+
+STATISTIC(NumAlgebraicIdentities, "Number of algebraic identities simplified");
+STATISTIC(NumIdioms, "Number of bit manipulation idioms replaced with intrinsics");
+STATISTIC(NumCompareFolds, "Number of integer comparisons folded");
+STATISTIC(NumSelectFolds, "Number of selects folded");
+STATISTIC(NumMulChains, "Number of multiplications by constant replaced with shift/add/sub chains");
+STATISTIC(NumDivisionsByConstant, "Number of divisions and remainders by constant lowered");
+STATISTIC(NumPowerOf2Lanes, "Number of vector operations by power of two lanes reduced to shifts and masks");
+STATISTIC(NumFPIdentities, "Number of floating point identities simplified");
+STATISTIC(NumFPStrengthReductions, "Number of floating point multiplications and divisions by constant reduced");
+STATISTIC(NumFPReassociations, "Number of floating point constant chains folded");
+STATISTIC(NumUnprofitableRewrites, "Number of rewrites skipped because not cheaper on the target");
+STATISTIC(NumColdRewrites, "Number of size increasing rewrites skipped in blocks optimized for size");
+STATISTIC(NumLinearFolds, "Number of add/sub/mul/shl chains folded into a single linear combination");
+STATISTIC(NumInversePairs, "Number of inverse operation pairs canceled");
+STATISTIC(NumRedundantInsts, "Number of redundant instructions removed by the CSE");
+STATISTIC(NumInductionMuls, "Number of multiplications of induction variables replaced with recurrences");
+STATISTIC(NumInductionRecurrences, "Number of additive recurrences created");
+STATISTIC(NumErasedInsts, "Number of replaced instructions erased");
+
 /**
     Custom type used to select the right optimization pass
 */
 typedef enum {
     ALGEBRAIC,
+    IDIOM,
+    COMPARE,
     STRENGTH,
     MULTI,
     ALL
 } opt;
 
 /**
- * Command-line option that enables verbose output for the optimizer.
- * When enabled, the pass will print detailed information about
- * each optimization that is applied, including:
- * - The original instruction before optimization
- * - The specific optimization rule that was applied
+ * Command-line option that limits the number of instructions a multiplication
+ * by constant can be replaced with. Longer sequences of shifts, adds and subs
+ * are not considered profitable, and the mul is kept.
+ *
+ * Use with `-local-opts-mul-cost-limit=<n>` when running the LLVM opt tool.
+ */
+static cl::opt<unsigned> MulCostLimit(
+    "local-opts-mul-cost-limit",
+    cl::desc(
+        "Maximum number of instructions emitted to replace a multiplication by constant"
+    ),
+    cl::init(7)
+);
+
+/**
+ * Command-line option that sets the minimum saving, in TargetTransformInfo cost units,
+ * a rewrite creating new instructions must achieve over the original instruction.
+ * The default only applies rewrites that are strictly cheaper; 0 also applies
+ * rewrites of equal cost.
  *
- * Use with `-local-opts-verbose` flag when running the LLVM opt tool.
+ * Use with `-local-opts-cost-threshold=<n>` when running the LLVM opt tool.
  */
-static cl::opt<bool> LocalOptsVerbose(
-    "local-opts-verbose",
+static cl::opt<int> CostThreshold(
+    "local-opts-cost-threshold",
     cl::desc(
-        "Enables verbose output for the different optimizations"
+        "Minimum cost saving for a rewrite to be applied"
     ),
-    cl::init(false)
+    cl::init(1)
 );
 
 /**
- * Converts an integer to a set of bit positions where '1's appear in its binary representation.
+ * Command-line option that selects the cost the rewrites are compared on.
+ * Latency is the default, since the rewrites replace multi-cycle instructions
+ * with chains of single-cycle ones.
+ *
+ * Use with `-local-opts-cost-kind=<kind>` when running the LLVM opt tool.
+ */
+static cl::opt<TargetTransformInfo::TargetCostKind> CostKind(
+    "local-opts-cost-kind",
+    cl::desc(
+        "Target cost used to decide whether a rewrite is profitable"
+    ),
+    cl::init(TargetTransformInfo::TCK_Latency),
+    cl::values(
+        clEnumValN(TargetTransformInfo::TCK_RecipThroughput, "throughput", "Reciprocal throughput"),
+        clEnumValN(TargetTransformInfo::TCK_Latency, "latency", "Instruction latency"),
+        clEnumValN(TargetTransformInfo::TCK_CodeSize, "code-size", "Code size"),
+        clEnumValN(TargetTransformInfo::TCK_SizeAndLatency, "size-latency", "Code size and latency")
+    )
+);
+
+/**
+ * Function-level worklist that drives the optimizations to a fixed point.
+ *
+ * Every instruction of the function is enqueued once before the optimizations start.
+ * Whenever an optimization rewrites an instruction, the users of the rewritten value
+ * and the instructions created by the rewrite are enqueued again, so that the
+ * simplifications enabled by a rewrite (e.g. an algebraic identity exposing a new
+ * strength reduction candidate) are applied within the same invocation of the pass.
+ *
+ * Rewritten instructions are not erased immediately, since other instructions in the
+ * worklist may still refer to them. They are collected in a pointer set and erased in
+ * bulk once the worklist is empty.
+ */
+class OptimizationWorklist {
+    private:
+        std::vector<Instruction*> worklist;
+        SmallPtrSet<Instruction*, 32> inWorklist;
+
+        // The vector keeps the erasure order deterministic, the set gives constant time lookups
+        std::vector<Instruction*> deadInsts;
+        SmallPtrSet<Instruction*, 32> deadSet;
+
+    public:
+        /**
+         * Returns true if the instruction has been marked as dead and nothing uses it anymore,
+         * meaning that there is no point in optimizing it.
+         */
+        bool isDead(Instruction *inst) const {
+            return deadSet.count(inst) && inst->use_empty();
+        }
+
+        /**
+         * Returns true if exactly one of the users of the value is still alive.
+         * The dead users keep their operands until they are erased, so
+         * Value::hasOneUse() would also count them.
+         */
+        bool hasOneLiveUser(Value *V) const {
+            unsigned liveUsers = 0;
+
+            for (User *user : V->users()) {
+                Instruction *userInst = dyn_cast<Instruction>(user);
+
+                if (!userInst || !isDead(userInst)) liveUsers++;
+            }
+
+            return liveUsers == 1;
+        }
+
+        /**
+         * Enqueues an instruction, unless it is already waiting in the worklist
+         * or it is dead.
+         */
+        void push(Instruction *inst) {
+            if (isDead(inst)) return;
+
+            if (inWorklist.insert(inst).second) {
+                worklist.push_back(inst);
+            }
+        }
+
+        /**
+         * Enqueues all the instructions using the given value.
+         */
+        void pushUsers(Value *V) {
+            for (User *user : V->users()) {
+                if (Instruction *userInst = dyn_cast<Instruction>(user)) {
+                    push(userInst);
+                }
+            }
+        }
+
+        /**
+         * Returns the next instruction to optimize, skipping the ones
+         * that have become dead in the meanwhile.
+         * Returns nullptr when the worklist is empty.
+         */
+        Instruction *pop() {
+            while (!worklist.empty()) {
+                Instruction *inst = worklist.back();
+                worklist.pop_back();
+                inWorklist.erase(inst);
+
+                if (!isDead(inst)) return inst;
+            }
+
+            return nullptr;
+        }
+
+        /**
+         * Marks an instruction as a candidate for removal.
+         * The instruction is erased by eraseDeadInstructions() only if it has no uses left.
+         */
+        void markDead(Instruction *inst) {
+            if (deadSet.insert(inst).second) {
+                deadInsts.push_back(inst);
+            }
+        }
+
+        /**
+         * Replaces all the uses of an instruction with the optimized value.
+         *
+         * The users of the instruction are enqueued again, since the rewrite could
+         * enable further optimizations on them, and the instruction is marked as dead.
+         */
+        void replace(Instruction &inst, Value *newValue) {
+            pushUsers(&inst);
+            inst.replaceAllUsesWith(newValue);
+            markDead(&inst);
+
+            if (Instruction *newInst = dyn_cast<Instruction>(newValue)) {
+                push(newInst);
+            }
+        }
+
+        /**
+         * Erases in bulk all the dead instructions that have no uses left.
+         *
+         * Erasing an instruction may leave one of its operands without uses;
+         * if the operand was marked as dead too, it is erased as well.
+         * Dead instructions that are still used are kept in the IR.
+         *
+         * @return true if at least one instruction was erased
+         */
+        bool eraseDeadInstructions() {
+            std::vector<Instruction*> toErase;
+
+            for (Instruction *inst : deadInsts) {
+                if (inst->use_empty()) toErase.push_back(inst);
+            }
+
+            bool erased = !toErase.empty();
+
+            while (!toErase.empty()) {
+                Instruction *inst = toErase.back();
+                toErase.pop_back();
+
+                // The same operand may have been enqueued more than once
+                if (!deadSet.count(inst)) continue;
+
+                LLVM_DEBUG(dbgs() << "Removing instruction: " << *inst << "\n");
+                ++NumErasedInsts;
+
+                SmallVector<Instruction*, 2> operands;
+                for (Value *op : inst->operands()) {
+                    if (Instruction *opInst = dyn_cast<Instruction>(op)) {
+                        operands.push_back(opInst);
+                    }
+                }
+
+                deadSet.erase(inst);
+                inst->eraseFromParent();
+
+                for (Instruction *opInst : operands) {
+                    if (deadSet.count(opInst) && opInst->use_empty()) {
+                        toErase.push_back(opInst);
+                    }
+                }
+            }
+
+            deadInsts.clear();
+            deadSet.clear();
+
+            return erased;
+        }
+};
+
+/**
+ * Collects the instructions of a rewrite that expands an instruction into a sequence.
+ *
+ * The new instructions are created detached from the function, so that the cost of the
+ * sequence can be compared with the one of the original instruction before touching the IR.
+ * If the rewrite is applied, commit() inserts them one after the other, starting right
+ * after the instruction being rewritten, and enqueues them, so that they can be further
+ * simplified. Otherwise they are deleted when the sequence goes out of scope.
+ */
+class InstructionSequence {
+    private:
+        Instruction *insertPoint;
+        OptimizationWorklist &worklist;
+        SmallVector<Instruction*, 16> pending;
+
+    public:
+        InstructionSequence(Instruction &inst, OptimizationWorklist &worklist)
+            : insertPoint(&inst), worklist(worklist) {}
+
+        InstructionSequence(const InstructionSequence &) = delete;
+        InstructionSequence &operator=(const InstructionSequence &) = delete;
+
+        ~InstructionSequence() {
+            // Every instruction can only be used by the following ones
+            for (Instruction *inst : reverse(pending)) {
+                inst->deleteValue();
+            }
+        }
+
+        ArrayRef<Instruction*> getInstructions() const {
+            return pending;
+        }
+
+        void commit() {
+            for (Instruction *inst : pending) {
+                inst->insertAfter(insertPoint);
+                worklist.push(inst);
+                insertPoint = inst;
+            }
+
+            pending.clear();
+        }
+
+        Instruction *append(Instruction *newInst) {
+            pending.push_back(newInst);
+
+            return newInst;
+        }
+
+        Instruction *binOp(Instruction::BinaryOps opCode, Value *LHS, Value *RHS, const Twine &name = "") {
+            return append(BinaryOperator::Create(opCode, LHS, RHS, name));
+        }
+
+        /**
+         * Appends a binary operation whose right operand is a constant of the type of LHS
+         */
+        Instruction *binOp(Instruction::BinaryOps opCode, Value *LHS, const APInt &RHS, const Twine &name = "") {
+            return binOp(opCode, LHS, ConstantInt::get(LHS->getType(), RHS), name);
+        }
+
+        Instruction *neg(Value *V) {
+            return binOp(Instruction::Sub, Constant::getNullValue(V->getType()), V, "neg");
+        }
+
+        Instruction *cast(Instruction::CastOps opCode, Value *V, Type *type) {
+            return append(CastInst::Create(opCode, V, type));
+        }
+
+        /**
+         * Appends a call to an intrinsic overloaded on the type of its first argument
+         */
+        Instruction *intrinsic(Intrinsic::ID id, ArrayRef<Value*> args) {
+            Function *callee = Intrinsic::getDeclaration(insertPoint->getModule(), id, {args[0]->getType()});
+
+            return append(CallInst::Create(callee, args));
+        }
+};
+
+/**
+ * Decides whether a rewrite creating new instructions is worth applying,
+ * comparing the target costs of the original instruction and of the new sequence.
+ *
+ * Modules without a target triple get the default TargetTransformInfo, which knows
+ * nothing about the actual instruction costs (every arithmetic instruction but the
+ * divisions costs 1): in that case every rewrite is considered profitable, and the
+ * strength reduction is only bounded by -local-opts-mul-cost-limit.
+ *
+ * Rewrites that increase the code size are only applied where speed matters: the blocks
+ * of optsize functions, and the blocks that are not hot according to the profile (see
+ * shouldOptimizeForSize(), which uses BlockFrequencyInfo and ProfileSummaryInfo), only
+ * get rewrites that do not grow the code. Without a profile every block is treated
+ * the same way, as before.
+ *
+ * The rewrites that are not applied because of their cost are reported as missed
+ * optimization remarks.
+ */
+class RewriteCostModel {
+    private:
+        const TargetTransformInfo &TTI;
+        OptimizationRemarkEmitter &ORE;
+        BlockFrequencyInfo *BFI;
+        ProfileSummaryInfo *PSI;
+        bool hasTarget;
+
+    public:
+        RewriteCostModel(
+            const TargetTransformInfo &TTI,
+            OptimizationRemarkEmitter &ORE,
+            BlockFrequencyInfo *BFI,
+            ProfileSummaryInfo *PSI,
+            bool hasTarget
+        ) : TTI(TTI), ORE(ORE), BFI(BFI), PSI(PSI), hasTarget(hasTarget) {}
+
+        InstructionCost getCost(const Instruction &inst, TargetTransformInfo::TargetCostKind kind = CostKind) const {
+            if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(&inst)) {
+                const Value *LHS = BO->getOperand(0);
+                const Value *RHS = BO->getOperand(1);
+
+                return TTI.getArithmeticInstrCost(
+                    BO->getOpcode(), BO->getType(), kind,
+                    TargetTransformInfo::getOperandInfo(LHS), TargetTransformInfo::getOperandInfo(RHS),
+                    {LHS, RHS}, BO);
+            }
+
+            return TTI.getInstructionCost(&inst, kind);
+        }
+
+        InstructionCost getCost(ArrayRef<Instruction*> insts, TargetTransformInfo::TargetCostKind kind = CostKind) const {
+            InstructionCost cost = 0;
+
+            for (Instruction *inst : insts) {
+                cost += getCost(*inst, kind);
+            }
+
+            return cost;
+        }
+
+        /**
+         * Returns true if replacing original with the given instructions makes the code larger.
+         * Without a target the size is the number of instructions.
+         */
+        bool isSizeIncreasing(const Instruction &original, ArrayRef<Instruction*> replacement) const {
+            if (!hasTarget) return replacement.size() > 1;
+
+            return getCost(replacement, TargetTransformInfo::TCK_CodeSize) > getCost(original, TargetTransformInfo::TCK_CodeSize);
+        }
+
+        /**
+         * Returns true if the block of the instruction should be kept small: the whole function
+         * is optsize, or the profile says that the block is not hot
+         */
+        bool isOptimizedForSize(const Instruction &inst) const {
+            return inst.getFunction()->hasOptSize() || shouldOptimizeForSize(inst.getParent(), PSI, BFI);
+        }
+
+        /**
+         * Returns true if the rewrite does not grow a block optimized for size, and if
+         * replacing original with the given instructions saves at least
+         * -local-opts-cost-threshold cost units
+         */
+        bool isProfitable(const Instruction &original, ArrayRef<Instruction*> replacement) const {
+            if (isOptimizedForSize(original) && isSizeIncreasing(original, replacement)) {
+                ++NumColdRewrites;
+
+                ORE.emit([&]() {
+                    return OptimizationRemarkMissed("strength-reduction", "ColdBlock", &original)
+                        << "rewrite of " << ore::NV("Instruction", &original)
+                        << " skipped: it would grow a block optimized for size";
+                });
+
+                return false;
+            }
+
+            if (!hasTarget) return true;
+
+            InstructionCost originalCost = getCost(original);
+            InstructionCost replacementCost = getCost(replacement);
+
+            if (!originalCost.isValid() || !replacementCost.isValid()) return false;
+
+            bool isProfitable = originalCost - replacementCost >= InstructionCost(CostThreshold);
+
+            if (!isProfitable) {
+                ++NumUnprofitableRewrites;
+
+                ORE.emit([&]() {
+                    return OptimizationRemarkMissed("strength-reduction", "Unprofitable", &original)
+                        << "rewrite of " << ore::NV("Instruction", &original) << " skipped: cost "
+                        << ore::NV("OriginalCost", originalCost) << ", rewrite cost "
+                        << ore::NV("RewriteCost", replacementCost);
+                });
+            }
+
+            return isProfitable;
+        }
+};
+
+/**
+ * Emits the instructions computing x * C described by a multiplication chain.
+ *
+ * The shift amounts have the type of the multiplication, as LLVM requires
+ * both operands of a shift to have the same type.
+ *
+ * @param V The non constant operand of the multiplication (x)
+ * @param chain The steps to emit
+ * @param seq The sequence the new instructions are appended to
+ * @return The value holding x * C
+ */
+Value *emitMulChain(Value *V, const MulChain &chain, InstructionSequence &seq) {
+    Type *type = V->getType();
+    Value *acc = V;
+
+    for (const MulStep &step : chain.steps) {
+        switch (step.kind) {
+            case MulStepKind::Shl:
+                acc = seq.binOp(Instruction::Shl, acc, ConstantInt::get(type, step.amount));
+            break;
+
+            case MulStepKind::AddX:
+                acc = seq.binOp(Instruction::Add, acc, V);
+            break;
+
+            case MulStepKind::SubX:
+                acc = seq.binOp(Instruction::Sub, acc, V);
+            break;
+
+            case MulStepKind::AddShifted:
+            case MulStepKind::SubShifted: {
+                Value *shifted = seq.binOp(Instruction::Shl, acc, ConstantInt::get(type, step.amount));
+                acc = seq.binOp(
+                    step.kind == MulStepKind::AddShifted ? Instruction::Add : Instruction::Sub, shifted, acc);
+            }
+            break;
+
+            case MulStepKind::Neg:
+                acc = seq.neg(acc);
+            break;
+        }
+    }
+
+    return acc;
+}
+
+/**
+ * Emits the high half of the double width product n * magic,
+ * as an extension to twice the bit width, a multiplication, a shift and a truncation.
+ * The backends recognize the pattern and select a multiply-high instruction.
+ * Vectors are extended lane by lane.
+ */
+Value *emitMulHigh(Value *n, const APInt &magic, bool isSigned, InstructionSequence &seq) {
+    unsigned width = magic.getBitWidth();
+    Type *wideType = n->getType()->getWithNewBitWidth(2 * width);
+
+    Value *wideN = seq.cast(isSigned ? Instruction::SExt : Instruction::ZExt, n, wideType);
+    Value *product = seq.binOp(Instruction::Mul, wideN, isSigned ? magic.sext(2 * width) : magic.zext(2 * width));
+    Value *high = seq.binOp(Instruction::LShr, product, APInt(2 * width, width));
+
+    return seq.cast(Instruction::Trunc, high, n->getType());
+}
+
+/**
+ * Emits the unsigned division n / d, d being a non zero constant
+ *
+ * - d = 2^k: n >> k, marked as exact if the low k bits of n are known to be zero
+ * - d >= 2^(width - 1): the quotient can only be 0 or 1, so it is n >= d
+ * - otherwise: multiplication by the magic number of d (see ConstantDivision.hpp)
+ */
+Value *emitUnsignedDivision(Value *n, const APInt &d, unsigned knownTrailingZeros, InstructionSequence &seq) {
+    if (d.isPowerOf2()) {
+        Instruction *q = seq.binOp(Instruction::LShr, n, APInt(d.getBitWidth(), d.logBase2()));
+        q->setIsExact(knownTrailingZeros >= d.logBase2());
+
+        return q;
+    }
+
+    if (d.isNegative()) {
+        Instruction *cmp = seq.append(new ICmpInst(ICmpInst::ICMP_UGE, n, ConstantInt::get(n->getType(), d)));
+        return seq.cast(Instruction::ZExt, cmp, n->getType());
+    }
+
+    DivisionMagic magic = getUnsignedDivisionMagic(d);
+    Value *q = emitMulHigh(n, magic.magic, false, seq);
+
+    if (magic.isAdd) {
+        // ((n - q) >> 1) + q computes (n + q) >> 1 without overflowing
+        Value *diff = seq.binOp(Instruction::Sub, n, q);
+        Value *half = seq.binOp(Instruction::LShr, diff, APInt(d.getBitWidth(), 1));
+        q = seq.binOp(Instruction::Add, half, q);
+    }
+
+    if (magic.shift > 0) {
+        q = seq.binOp(Instruction::LShr, q, APInt(d.getBitWidth(), magic.shift));
+    }
+
+    return q;
+}
+
+/**
+ * Emits the signed division n / d, d being a non zero constant
+ *
+ * - |d| = 2^k: negative dividends are biased by 2^k - 1 before the arithmetic shift,
+ *   so that the quotient is rounded towards zero, then the quotient is negated if d < 0.
+ *   If the low k bits of n are known to be zero there is nothing to round, and the
+ *   division is a plain exact arithmetic shift.
+ * - otherwise: multiplication by the magic number of d (see ConstantDivision.hpp),
+ *   adding one to negative quotients to round them towards zero
+ */
+Value *emitSignedDivision(Value *n, const APInt &d, unsigned knownTrailingZeros, InstructionSequence &seq) {
+    unsigned width = d.getBitWidth();
+    APInt absD = d.abs();   // INT_MIN stays INT_MIN, which is 2^(width - 1) if read as unsigned
+
+    if (absD.isPowerOf2()) {
+        unsigned k = absD.logBase2();
+        Value *q = n;
+
+        if (k > 0 && knownTrailingZeros >= k) {
+            Instruction *shift = seq.binOp(Instruction::AShr, n, APInt(width, k));
+            shift->setIsExact(true);
+            q = shift;
+        } else if (k > 0) {
+            // n < 0 ? 2^k - 1 : 0, obtained from the sign bits of n
+            Value *sign = k > 1 ? seq.binOp(Instruction::AShr, n, APInt(width, k - 1)) : n;
+            Value *bias = seq.binOp(Instruction::LShr, sign, APInt(width, width - k));
+            Value *biased = seq.binOp(Instruction::Add, n, bias);
+            q = seq.binOp(Instruction::AShr, biased, APInt(width, k));
+        }
+
+        return d.isNegative() ? seq.neg(q) : q;
+    }
+
+    DivisionMagic magic = getSignedDivisionMagic(d);
+    Value *q = emitMulHigh(n, magic.magic, true, seq);
+
+    if (magic.isAdd) {
+        q = seq.binOp(d.isNegative() ? Instruction::Sub : Instruction::Add, q, n);
+    }
+
+    if (magic.shift > 0) {
+        q = seq.binOp(Instruction::AShr, q, APInt(width, magic.shift));
+    }
+
+    Value *isNegative = seq.binOp(Instruction::LShr, q, APInt(width, width - 1));
+
+    return seq.binOp(Instruction::Add, q, isNegative);
+}
+
+/**
+ * Lowers a division or a remainder by a constant into shifts and multiplications.
+ *
+ * Remainders are computed as n - (n / d) * d; the multiplication is enqueued, so that
+ * it can be strength reduced in turn. If the dividend of a signed operation is known to be
+ * non negative, the cheaper unsigned lowering is used, since the results coincide
+ * (e.g. a signed division by 2^k becomes a plain shift).
+ *
+ * @param inst The sdiv, udiv, srem or urem instruction
+ * @param n The dividend
+ * @param d The divisor, must not be zero
+ * @param seq The sequence the new instructions are appended to
+ * @param type Output parameter holding the description of the transformation
+ * @return The value holding the result of the instruction
+ */
+Value *emitDivisionByConstant(Instruction &inst, Value *n, const APInt &d, InstructionSequence &seq, std::string &type) {
+    unsigned opCode = inst.getOpcode();
+    bool isSigned = opCode == Instruction::SDiv || opCode == Instruction::SRem;
+    bool isRemainder = opCode == Instruction::URem || opCode == Instruction::SRem;
+
+    KnownBits known = computeKnownBits(n, inst.getModule()->getDataLayout());
+
+    // A known zero sign bit makes the signed operation equal to the unsigned one on |d|,
+    // the quotient only has to be negated for negative divisors
+    bool isDividendNonNegative = isSigned && known.isNonNegative();
+
+    APInt divisor = isDividendNonNegative ? d.abs() : d;
+    bool isUnsigned = !isSigned || isDividendNonNegative;
+
+    if (isRemainder && isUnsigned && divisor.isPowerOf2()) {
+        type = "x % 2^n ==> x & (2^n - 1)";
+        return seq.binOp(Instruction::And, n, divisor - 1);
+    }
+
+    unsigned knownTrailingZeros = known.countMinTrailingZeros();
+    Value *q = isUnsigned ?
+        emitUnsignedDivision(n, divisor, knownTrailingZeros, seq) :
+        emitSignedDivision(n, divisor, knownTrailingZeros, seq);
+
+    if (isRemainder) {
+        type = "x % c ==> x - (x / c) * c, with x / c ==> multiply-high and shifts";
+        Value *product = seq.binOp(Instruction::Mul, q, divisor);
+        return seq.binOp(Instruction::Sub, n, product);
+    }
+
+    if (isDividendNonNegative && d.isNegative()) q = seq.neg(q);
+
+    if (d.abs().isPowerOf2()) {
+        type = isUnsigned ? "x / 2^n ==> x >> n" : "x / 2^n ==> (x + (x < 0 ? 2^n - 1 : 0)) >> n";
+    } else {
+        type = "x / c ==> multiply-high by magic number and shifts";
+    }
+
+    return q;
+}
+
+/**
+ * Simplifies a floating point operation with the identities allowed by its fast-math flags.
  *
- * For example, for n=10 (binary: 1010), the function returns {1,3} because bits at
- * positions 1 and 3 are set.
+ * Without flags only the identities exact for every input apply (x * 1.0 = x,
+ * x + -0.0 = x, x - 0.0 = x, x / 1.0 = x); the others need the flags listed in
+ * FloatingPointRules.hpp, e.g. x + 0.0 = x needs nsz and x * 0.0 = 0.0 needs nnan and nsz.
  *
- * This helper function is used during strength reduction to decompose constant
- * multipliers into their power-of-2 components.
+ * @param inst The instruction to be optimized
+ * @param worklist The function worklist, used to replace the instruction and enqueue its users
+ * @param ORE The remark emitter of the function
+ * @return true if the instruction was optimized (and marked for removal), false otherwise
+ */
+bool floatingPointIdentity(Instruction &inst, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    BinaryOperator *BO = dyn_cast<BinaryOperator>(&inst);
+    if (!BO) return false;
+
+    Value *variable = nullptr;  // Non constant operand of the matched identity
+    const FPIdentityRule *rule = findFPIdentity(*BO, variable);
+
+    if (!rule) return false;
+
+    Value *newValue = getFPIdentityResult(rule->result, inst.getType(), variable);
+
+    ++NumFPIdentities;
+
+    ORE.emit([&]() {
+        return OptimizationRemark("algebraic-identity", "FPIdentity", &inst)
+            << "simplified " << ore::NV("Instruction", &inst) << " with identity "
+            << ore::NV("Identity", rule->description);
+    });
+
+    worklist.replace(inst, newValue);
+
+    return true;
+}
+
+/**
+ * Optimize instructions based on algebraic identities.
+ *
+ * This function recognizes and applies common algebraic simplification rules
+ * to reduce computation overhead. It handles several categories of identities:
+ *
+ * Zero-based identities:
+ * - x - x = 0, x ^ x = 0 (resulting in constant zero)
+ * - x * 0 = 0, x & 0 = 0 (absorbing constants)
+ *
+ * Identity operations:
+ * - x + 0 = x, x - 0 = x, x << 0 = x, x >> 0 = x, x ^ 0 = x, x | 0 = x (no effect)
+ * - x & x = x, x | x = x (idempotent operations)
+ * - x / x = 1 (division by self)
+ * - x * 1 = x, x / 1 = x (multiplication/division by one)
+ * - x & -1 = x, x | -1 = -1 (all ones masks)
+ *
+ * Implementation details:
+ * - The identities are entries of the declarative IdentityRules table
+ *   (see AlgebraicIdentityRules.hpp), dispatched by opcode through an array
+ *   built at compile time
+ * - Commutative operations are matched with the constant on either side
+ * - Vector operations are matched when their constant is a splat
+ *   (e.g. x + zeroinitializer = x)
+ * - The identity description is reported as an optimization remark
+ * - Replaces the original instruction with the simplified value
+ *
+ * @param inst The instruction to be optimized
+ * @param worklist The function worklist, used to replace the instruction and enqueue its users
+ * @param ORE The remark emitter of the function
+ * @return true if the instruction was optimized (and marked for removal), false otherwise
+ */
+bool algebraicIdentityOptimization(Instruction &inst, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    if (inst.getType()->isFPOrFPVectorTy()) return floatingPointIdentity(inst, worklist, ORE);
+
+    BinaryOperator *BO = dyn_cast<BinaryOperator>(&inst);
+    if (!BO) return false;
+
+    Value *variable = nullptr;  // Non constant operand of the matched identity
+    const IdentityRule *rule = findAlgebraicIdentity(*BO, variable);
+
+    if (!rule) return false;
+
+    Value *newValue = getIdentityResult(rule->result, inst.getType(), variable);
+
+    ++NumAlgebraicIdentities;
+
+    ORE.emit([&]() {
+        return OptimizationRemark("algebraic-identity", "AlgebraicIdentity", &inst)
+            << "simplified " << ore::NV("Instruction", &inst) << " with identity "
+            << ore::NV("Identity", rule->description);
+    });
+
+    // Replace all uses of the original instruction with the new optimized value
+    worklist.replace(inst, newValue);
+
+    return true;
+}
+
+/**
+ * Description of an idiom matched by one of the match*() functions: the intrinsic
+ * the idiom is replaced with and its arguments
+ */
+struct IdiomMatch {
+    Intrinsic::ID intrinsic = Intrinsic::not_intrinsic;
+    SmallVector<Value*, 3> args;
+    const char *name = nullptr;    // Only used by the optimization remarks
+};
+
+/**
+ * Matches a rotate, or more generally a funnel shift, written with two shifts:
+ * - (x << c) | (y >> (W - c)) = fshl(x, y, c), with constant c
+ * - (x << r) | (y >> (W - r)) = fshl(x, y, r)
+ * - (x << (W - r)) | (y >> r) = fshr(x, y, r)
+ * - (x << (r & (W - 1))) | (x >> (-r & (W - 1))) = fshl(x, x, r), with W power of two
+ *
+ * The first three forms are poison when the shift amount is 0 or at least W, so
+ * the funnel shift is a refinement. The masked form is the one written to avoid
+ * the undefined shift: it is defined for every r, but only a rotate (x = y) gives
+ * the same result as the funnel shift for r = 0.
+ */
+bool matchRotate(Instruction &inst, IdiomMatch &idiom) {
+    using namespace PatternMatch;
+
+    Value *X, *Y, *shlAmount, *shrAmount;
+
+    if (!match(&inst, m_c_Or(m_Shl(m_Value(X), m_Value(shlAmount)), m_LShr(m_Value(Y), m_Value(shrAmount))))) {
+        return false;
+    }
+
+    unsigned width = inst.getType()->getScalarSizeInBits();
+    const APInt *C1, *C2;
+    Value *R;
+
+    if (match(shlAmount, m_APInt(C1)) && match(shrAmount, m_APInt(C2))) {
+        if (!C1->ult(width) || !C2->ult(width) || C1->getZExtValue() + C2->getZExtValue() != width) return false;
+
+        idiom = {Intrinsic::fshl, {X, Y, shlAmount}, "rotate"};
+    } else if (match(shrAmount, m_Sub(m_SpecificInt(width), m_Specific(shlAmount)))) {
+        idiom = {Intrinsic::fshl, {X, Y, shlAmount}, "rotate"};
+    } else if (match(shlAmount, m_Sub(m_SpecificInt(width), m_Specific(shrAmount)))) {
+        idiom = {Intrinsic::fshr, {X, Y, shrAmount}, "rotate"};
+    } else if (
+        X == Y && isPowerOf2_32(width) &&
+        match(shlAmount, m_And(m_Value(R), m_SpecificInt(width - 1))) &&
+        match(shrAmount, m_And(m_Neg(m_Specific(R)), m_SpecificInt(width - 1)))
+    ) {
+        idiom = {Intrinsic::fshl, {X, X, R}, "rotate"};
+    } else {
+        return false;
+    }
+
+    if (X == Y) return true;
+
+    idiom.name = "funnel shift";
+
+    return true;
+}
+
+/**
+ * Matches the branch free population count of "Bit Twiddling Hacks", for any
+ * width multiple of 8 up to 128 (0x55.., 0x33.., 0x0F.. and 0x01.. are byte splats):
+ *
+ *   x1 = x - ((x >> 1) & 0x55..)
+ *   x2 = (x1 & 0x33..) + ((x1 >> 2) & 0x33..)
+ *   x3 = (x2 + (x2 >> 4)) & 0x0F..
+ *   ctpop(x) = (x3 * 0x01..) >> (W - 8)
  *
- * @param n The integer to analyze
- * @return A set containing the bit positions of all set bits in n
+ * The multiplication sums the bytes of x3 in the top byte, which only holds the
+ * count while it is below 256: from i256 on, the sequence computes the count
+ * modulo 256 and is not a population count.
  */
-std::set<int> getExpSet(int n) {
-    std::set<int> expSet;
+bool matchPopCount(Instruction &inst, IdiomMatch &idiom) {
+    using namespace PatternMatch;
+
+    unsigned width = inst.getType()->getScalarSizeInBits();
+    if (width % 8 != 0 || width < 16 || width > 128) return false;
+
+    auto byteSplat = [width](uint8_t byte) { return APInt::getSplat(width, APInt(8, byte)); };
+
+    Value *x1, *x2, *x3, *X;
+
+    if (!match(&inst, m_LShr(m_Mul(m_Value(x3), m_SpecificInt(byteSplat(0x01))), m_SpecificInt(width - 8)))) {
+        return false;
+    }
+
+    if (!match(x3, m_And(m_c_Add(m_Value(x2), m_LShr(m_Deferred(x2), m_SpecificInt(4))), m_SpecificInt(byteSplat(0x0F))))) {
+        return false;
+    }
+
+    if (!match(x2, m_c_Add(
+        m_And(m_Value(x1), m_SpecificInt(byteSplat(0x33))),
+        m_And(m_LShr(m_Deferred(x1), m_SpecificInt(2)), m_SpecificInt(byteSplat(0x33)))
+    ))) {
+        return false;
+    }
+
+    if (!match(x1, m_Sub(m_Value(X), m_And(m_LShr(m_Deferred(X), m_SpecificInt(1)), m_SpecificInt(byteSplat(0x55)))))) {
+        return false;
+    }
+
+    idiom = {Intrinsic::ctpop, {X}, "population count"};
+
+    return true;
+}
+
+/**
+ * Matches the bit smear x | (x >> 1) | (x >> 2) | ... | (x >> (W - 1)), written as
+ * x |= x >> 1, x |= x >> 2, ..., x |= x >> (W / 2), which sets every bit below the
+ * most significant set bit of x.
+ *
+ * @return x, or nullptr if V is not a bit smear
+ */
+Value *matchBitSmear(Value *V, unsigned width) {
+    using namespace PatternMatch;
+
+    if (!isPowerOf2_32(width) || width < 2) return nullptr;
+
+    for (unsigned shift = width / 2; shift >= 1; shift /= 2) {
+        Value *inner;
+
+        if (!match(V, m_c_Or(m_Value(inner), m_LShr(m_Deferred(inner), m_SpecificInt(shift))))) return nullptr;
+
+        V = inner;
+    }
+
+    return V;
+}
+
+/**
+ * Matches the count of the leading zeros computed through a bit smear:
+ * - ctpop(~smear(x)) = ctlz(x)
+ * - W - ctpop(smear(x)) = ctlz(x)
+ *
+ * For x = 0 both are W, so the ctlz is defined on zero. The ctpop usually comes
+ * from matchPopCount(), the users of the replaced instruction being enqueued again.
+ */
+bool matchCountLeadingZeros(Instruction &inst, IdiomMatch &idiom) {
+    using namespace PatternMatch;
+
+    unsigned width = inst.getType()->getScalarSizeInBits();
+    Value *smear;
+
+    if (
+        !match(&inst, m_Intrinsic<Intrinsic::ctpop>(m_Not(m_Value(smear)))) &&
+        !match(&inst, m_Sub(m_SpecificInt(width), m_Intrinsic<Intrinsic::ctpop>(m_Value(smear))))
+    ) {
+        return false;
+    }
+
+    Value *X = matchBitSmear(smear, width);
+    if (!X) return false;
+
+    idiom = {Intrinsic::ctlz, {X, ConstantInt::getFalse(inst.getContext())}, "count leading zeros"};
+
+    return true;
+}
+
+/**
+ * Marks as dead the instructions computing root from the idiom arguments,
+ * which are left without uses once root is replaced.
+ */
+void markIdiomDead(Instruction &root, ArrayRef<Value*> args, OptimizationWorklist &worklist) {
+    SmallVector<Instruction*, 16> stack = {&root};
+    SmallPtrSet<Instruction*, 16> visited;
+
+    while (!stack.empty()) {
+        Instruction *inst = stack.pop_back_val();
+
+        for (Value *op : inst->operands()) {
+            Instruction *opInst = dyn_cast<Instruction>(op);
+
+            // Instructions with side effects are kept even if they have no uses left
+            if (!opInst || opInst->mayHaveSideEffects() || is_contained(args, op)) continue;
+
+            if (visited.insert(opInst).second) {
+                worklist.markDead(opInst);
+                stack.push_back(opInst);
+            }
+        }
+    }
+}
+
+/**
+ * Recognizes bit manipulation idioms written with shifts, masks and arithmetic,
+ * and replaces them with the intrinsic the backend lowers to a single instruction
+ * when the target has one:
+ * - Rotates and funnel shifts: (x << c) | (x >> (W - c)) = fshl(x, x, c), see matchRotate()
+ * - Population count: the bit twiddling sequence = ctpop(x), see matchPopCount()
+ * - Count of leading zeros: ctpop(~smear(x)) = ctlz(x), see matchCountLeadingZeros()
+ * - Byte swaps: any composition of shifts, masks and ors that reverses the bytes of
+ *   a value, matched by recognizeBSwapOrBitReverseIdiom(), also used by InstCombine
+ *
+ * The population count loops (while (x) { x &= x - 1; ++n; }) are not local
+ * idioms: they are recognized by LoopIdiomRecognize.
+ *
+ * @param inst The root of the idiom, e.g. the or combining the two shifts of a rotate
+ * @param worklist The function worklist, used to replace the instruction and mark the idiom as dead
+ * @param ORE The remark emitter of the function
+ * @return true if the instruction was replaced with an intrinsic, false otherwise
+ */
+bool idiomRecognition(Instruction &inst, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    if (!inst.getType()->isIntOrIntVectorTy()) return false;
+
+    IdiomMatch idiom;
+
+    if (matchRotate(inst, idiom) || matchPopCount(inst, idiom) || matchCountLeadingZeros(inst, idiom)) {
+        InstructionSequence seq(inst, worklist);
+        Instruction *call = seq.intrinsic(idiom.intrinsic, idiom.args);
+
+        ++NumIdioms;
+
+        ORE.emit([&]() {
+            return OptimizationRemark("idiom-recognition", "Idiom", &inst)
+                << "replaced " << ore::NV("Idiom", idiom.name) << " "
+                << ore::NV("Instruction", &inst) << " with " << ore::NV("Intrinsic", Intrinsic::getBaseName(idiom.intrinsic));
+        });
+
+        markIdiomDead(inst, idiom.args, worklist);
+        seq.commit();
+        worklist.replace(inst, call);
+
+        return true;
+    }
+
+    // The byte swaps have too many shapes to be matched by hand. Their instructions
+    // are inserted before inst, the last one computing its value
+    SmallVector<Instruction*, 4> inserted;
+
+    if (
+        inst.getOpcode() != Instruction::Or ||
+        !recognizeBSwapOrBitReverseIdiom(&inst, true, false, inserted)
+    ) {
+        return false;
+    }
+
+    ++NumIdioms;
+
+    ORE.emit([&]() {
+        return OptimizationRemark("idiom-recognition", "Idiom", &inst)
+            << "replaced " << ore::NV("Idiom", "byte swap") << " "
+            << ore::NV("Instruction", &inst) << " with " << ore::NV("Intrinsic", "llvm.bswap");
+    });
+
+    // The values swapped by the intrinsic are the only operands not created by the match
+    SmallVector<Value*, 2> swapped;
+
+    for (Instruction *newInst : inserted) {
+        worklist.push(newInst);
+
+        for (Value *op : newInst->operands()) {
+            if (!is_contained(inserted, op) && !isa<Constant>(op)) swapped.push_back(op);
+        }
+    }
+
+    markIdiomDead(inst, swapped, worklist);
+    worklist.replace(inst, inserted.back());
+
+    return true;
+}
+
+/**
+ * Folds an integer comparison whose result does not depend on the operands being compared:
+ * - x == x, x <= x, x >= x are true, x != x, x < x, x > x are false
+ * - (x + C1) == C2 → x == C2 - C1, (x - C1) == C2 → x == C2 + C1, (x ^ C1) == C2 → x == C2 ^ C1,
+ *   and the same for !=: the operations are bijective, so wrapping does not matter
+ * - (x + C1) < C2 → x < C2 - C1 and (x - C1) < C2 → x < C2 + C1, for the signed predicates if
+ *   the operation is nsw, for the unsigned ones if it is nuw, and only if the new constant
+ *   does not overflow (the comparison would have a constant result otherwise)
+ *
+ * Comparisons with the constant on the left are handled by swapping the predicate.
+ *
+ * @param cmp The comparison to be folded
+ * @param worklist The function worklist, used to replace the comparison and enqueue its users
+ * @param ORE The remark emitter of the function
+ * @return true if the comparison was folded, false otherwise
+ */
+bool foldCompare(ICmpInst &cmp, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    ICmpInst::Predicate pred = cmp.getPredicate();
+    Value *LHS = cmp.getOperand(0);
+    Value *RHS = cmp.getOperand(1);
+
+    if (LHS == RHS) {
+        ++NumCompareFolds;
+
+        ORE.emit([&]() {
+            return OptimizationRemark("compare-fold", "CompareFold", &cmp)
+                << "folded " << ore::NV("Instruction", &cmp) << " comparing a value with itself";
+        });
+
+        worklist.replace(cmp, ConstantInt::get(cmp.getType(), ICmpInst::isTrueWhenEqual(pred)));
+
+        return true;
+    }
+
+    const APInt *C2;
+
+    if (!PatternMatch::match(RHS, PatternMatch::m_APInt(C2))) {
+        if (!PatternMatch::match(LHS, PatternMatch::m_APInt(C2))) return false;
+
+        std::swap(LHS, RHS);
+        pred = ICmpInst::getSwappedPredicate(pred);
+    }
+
+    BinaryOperator *BO = dyn_cast<BinaryOperator>(LHS);
+    if (!BO) return false;
+
+    const APInt *C1;
+    Value *variable;
+
+    if (PatternMatch::match(BO->getOperand(1), PatternMatch::m_APInt(C1))) {
+        variable = BO->getOperand(0);
+    } else if (BO->isCommutative() && PatternMatch::match(BO->getOperand(0), PatternMatch::m_APInt(C1))) {
+        variable = BO->getOperand(1);
+    } else {
+        return false;
+    }
+
+    bool isEquality = ICmpInst::isEquality(pred);
+    bool isSigned = ICmpInst::isSigned(pred);
+    bool overflow = false;
+    APInt newC;
+
+    switch (BO->getOpcode()) {
+        case Instruction::Add:
+            if (isEquality) newC = *C2 - *C1;
+            else newC = isSigned ? C2->ssub_ov(*C1, overflow) : C2->usub_ov(*C1, overflow);
+            break;
+
+        case Instruction::Sub:
+            if (isEquality) newC = *C2 + *C1;
+            else newC = isSigned ? C2->sadd_ov(*C1, overflow) : C2->uadd_ov(*C1, overflow);
+            break;
+
+        case Instruction::Xor:
+            if (!isEquality) return false;
+            newC = *C2 ^ *C1;
+            break;
+
+        default:
+            return false;
+    }
+
+    if (!isEquality && (overflow || !(isSigned ? BO->hasNoSignedWrap() : BO->hasNoUnsignedWrap()))) return false;
+
+    InstructionSequence seq(cmp, worklist);
+    Instruction *newCmp = seq.append(new ICmpInst(pred, variable, ConstantInt::get(variable->getType(), newC)));
+
+    ++NumCompareFolds;
+
+    ORE.emit([&]() {
+        return OptimizationRemark("compare-fold", "CompareFold", &cmp)
+            << "folded the constant of " << ore::NV("Operation", BO) << " into "
+            << ore::NV("Instruction", &cmp);
+    });
+
+    // The operation is erased if the comparison was its only user
+    worklist.markDead(BO);
+    seq.commit();
+    worklist.replace(cmp, newCmp);
+
+    return true;
+}
+
+/**
+ * Folds a select that always produces the same value:
+ * - select c, x, x = x
+ * - select true, x, y = x, select false, x, y = y (also with splat vector conditions)
+ * - select c, true, false = c
+ *
+ * @param select The select to be folded
+ * @param worklist The function worklist, used to replace the select and enqueue its users
+ * @param ORE The remark emitter of the function
+ * @return true if the select was folded, false otherwise
+ */
+bool foldSelect(SelectInst &select, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    Value *cond = select.getCondition();
+    Value *trueValue = select.getTrueValue();
+    Value *falseValue = select.getFalseValue();
+    Value *newValue;
+    const char *description;
+
+    if (trueValue == falseValue) {
+        newValue = trueValue;
+        description = "select c, x, x = x";
+    } else if (PatternMatch::match(cond, PatternMatch::m_One())) {
+        newValue = trueValue;
+        description = "select true, x, y = x";
+    } else if (PatternMatch::match(cond, PatternMatch::m_Zero())) {
+        newValue = falseValue;
+        description = "select false, x, y = y";
+    } else if (
+        cond->getType() == select.getType() &&
+        PatternMatch::match(trueValue, PatternMatch::m_One()) &&
+        PatternMatch::match(falseValue, PatternMatch::m_Zero())
+    ) {
+        newValue = cond;
+        description = "select c, true, false = c";
+    } else {
+        return false;
+    }
+
+    ++NumSelectFolds;
+
+    ORE.emit([&]() {
+        return OptimizationRemark("compare-fold", "SelectFold", &select)
+            << "simplified " << ore::NV("Instruction", &select) << " with identity "
+            << ore::NV("Identity", description);
+    });
+
+    worklist.replace(select, newValue);
+
+    return true;
+}
+
+/**
+ * Folds the comparisons and the selects whose result is known, or can be computed
+ * with fewer instructions, see foldCompare() and foldSelect(). Comparisons feeding
+ * branches are on the critical path, so (x + 5) < 10 → x < 5 removes the add from it
+ * when the comparison is its only user.
+ *
+ * @param inst The instruction to be optimized
+ * @param worklist The function worklist, used to replace the instruction and enqueue its users
+ * @param ORE The remark emitter of the function
+ * @return true if the instruction was folded (and marked for removal), false otherwise
+ */
+bool compareFolding(Instruction &inst, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    if (ICmpInst *cmp = dyn_cast<ICmpInst>(&inst)) return foldCompare(*cmp, worklist, ORE);
+    if (SelectInst *select = dyn_cast<SelectInst>(&inst)) return foldSelect(*select, worklist, ORE);
+
+    return false;
+}
+
+/**
+ * Lowers a multiplication, unsigned division or unsigned remainder by a non uniform
+ * constant vector whose lanes are all powers of two: every lane gets its own shift
+ * amount or mask, e.g. x * <2, 4, 8, 16> becomes x << <1, 2, 3, 4>.
+ *
+ * Signed divisions are left alone, since their rounding fix-up depends on the shift
+ * amount, and so are vectors with undefined lanes.
+ *
+ * @param opCode The opcode of the instruction being reduced
+ * @param V The non constant operand
+ * @param C The constant vector
+ * @param seq The sequence the new instructions are appended to
+ * @param type Output parameter holding the description of the transformation
+ * @return The value holding the result, nullptr if the constant cannot be reduced
+ */
+Value *emitPowerOf2Lanes(unsigned opCode, Value *V, Constant *C, InstructionSequence &seq, std::string &type) {
+    FixedVectorType *vectorType = dyn_cast<FixedVectorType>(C->getType());
+    if (!vectorType) return nullptr;
+
+    SmallVector<Constant*, 16> log2Lanes;
+    SmallVector<Constant*, 16> maskLanes;
+
+    for (unsigned i = 0; i < vectorType->getNumElements(); i++) {
+        ConstantInt *lane = dyn_cast_or_null<ConstantInt>(C->getAggregateElement(i));
+        if (!lane || !lane->getValue().isPowerOf2()) return nullptr;
+
+        log2Lanes.push_back(ConstantInt::get(lane->getType(), lane->getValue().logBase2()));
+        maskLanes.push_back(ConstantInt::get(lane->getType(), lane->getValue() - 1));
+    }
+
+    switch (opCode) {
+        case Instruction::Mul:
+            type = "x * <2^n1, 2^n2, ...> ==> x << <n1, n2, ...>";
+            return seq.binOp(Instruction::Shl, V, ConstantVector::get(log2Lanes));
+
+        case Instruction::UDiv:
+            type = "x / <2^n1, 2^n2, ...> ==> x >> <n1, n2, ...>";
+            return seq.binOp(Instruction::LShr, V, ConstantVector::get(log2Lanes));
+
+        case Instruction::URem:
+            type = "x % <2^n1, 2^n2, ...> ==> x & <2^n1 - 1, 2^n2 - 1, ...>";
+            return seq.binOp(Instruction::And, V, ConstantVector::get(maskLanes));
+
+        default:
+            return nullptr;
+    }
+}
+
+/**
+ * Replaces expensive floating point operations by constant with cheaper ones:
+ * - x * 2.0 = x + x, exact for every input
+ * - x / c = x * (1 / c), when 1 / c is exactly representable (c is a power of two
+ *   and its inverse is a normal number), exact for every input
+ * - x / c = x * (1 / c) for any other c, when the division allows reciprocals (arcp),
+ *   provided that the rounded 1 / c is a normal number
+ *
+ * The new instruction keeps the fast-math flags of the original one. As for the
+ * integer rewrites, the cost model decides whether the new instruction is cheaper.
+ *
+ * @param inst The instruction to be optimized
+ * @param worklist The function worklist, used to replace the instruction and enqueue the new one
+ * @param costModel Decides whether the new instruction is cheaper than the original one
+ * @param ORE The remark emitter of the function
+ * @return true if optimization was applied, false otherwise
+ */
+bool floatingPointStrengthReduction(
+    Instruction &inst,
+    OptimizationWorklist &worklist,
+    const RewriteCostModel &costModel,
+    OptimizationRemarkEmitter &ORE
+) {
+    Value *V = nullptr;
+    const APFloat *C = nullptr;
+    Type *type = inst.getType();
+
+    InstructionSequence seq(inst, worklist);
+    std::string description = "";
+
+    if (
+        inst.getOpcode() == Instruction::FMul &&
+        (PatternMatch::match(&inst, PatternMatch::m_FMul(PatternMatch::m_Value(V), PatternMatch::m_APFloat(C))) ||
+        PatternMatch::match(&inst, PatternMatch::m_FMul(PatternMatch::m_APFloat(C), PatternMatch::m_Value(V)))) &&
+        C->isExactlyValue(2.0)
+    ) {
+        seq.binOp(Instruction::FAdd, V, V);
+        description = "x * 2.0 ==> x + x";
+    } else if (PatternMatch::match(&inst, PatternMatch::m_FDiv(PatternMatch::m_Value(V), PatternMatch::m_APFloat(C)))) {
+        APFloat reciprocal(C->getSemantics());
+
+        if (C->getExactInverse(&reciprocal)) {
+            description = "x / c ==> x * (1 / c), exact reciprocal";
+        } else if (inst.hasAllowReciprocal()) {
+            reciprocal = APFloat(C->getSemantics(), 1);
+
+            if (reciprocal.divide(*C, APFloat::rmNearestTiesToEven) & APFloat::opInvalidOp) return false;
+            if (!reciprocal.isNormal()) return false;
+
+            description = "x / c ==> x * (1 / c), approximate reciprocal (arcp)";
+        } else {
+            return false;
+        }
+
+        seq.binOp(Instruction::FMul, V, ConstantFP::get(type, reciprocal));
+    } else {
+        return false;
+    }
+
+    Instruction *newInst = seq.getInstructions().back();
+    newInst->copyFastMathFlags(&inst);
+
+    if (!costModel.isProfitable(inst, seq.getInstructions())) return false;
+
+    ++NumFPStrengthReductions;
+
+    ORE.emit([&]() {
+        return OptimizationRemark("strength-reduction", "FPStrengthReduction", &inst)
+            << "reduced " << ore::NV("Instruction", &inst) << ": " << ore::NV("Transformation", description);
+    });
+
+    seq.commit();
+    worklist.replace(inst, newInst);
+
+    return true;
+}
+
+/**
+ * Apply strength reduction optimizations to convert expensive operations to cheaper ones.
+ *
+ * Strength reduction replaces computationally expensive operations with equivalent but
+ * more efficient sequences. This optimization targets:
+ *
+ * 1. Multiplication by constant:
+ *    - x * c becomes the cheapest sequence of shifts, adds and subs found by findMulChain()
+ *      (e.g. x * 8 becomes x << 3, x * 7 becomes (x << 3) - x, x * 45 becomes
+ *      (t << 3) + t with t = (x << 2) + x)
+ *    - Negative constants are either encoded directly or reduced as -(x * -c)
+ *    - The multiplication is kept if the sequence needs more than
+ *      -local-opts-mul-cost-limit instructions
+ *
+ * 2. Division and remainder by constant:
+ *    - x / 2^n becomes x >> n (arithmetic shift with rounding fix-up for signed divisions)
+ *    - x % 2^n becomes x & (2^n - 1) for unsigned (or non negative) dividends
+ *    - x / c becomes a multiply-high by a magic number followed by shifts
+ *      (see ConstantDivision.hpp), x % c becomes x - (x / c) * c
+ *    - Signed operations on dividends known to be non negative use the unsigned lowering
+ *
+ * 3. Vectors:
+ *    - Splat constants are reduced like scalars, the new constants being splats too
+ *    - Non uniform constants are reduced lane by lane when every lane is a power of two
+ *      (mul, udiv and urem only, see emitPowerOf2Lanes())
+ *
+ * Implementation details:
+ * - Constants are handled as APInt, so every integer width is supported
+ * - The new sequence is built detached from the function and only inserted if the
+ *   RewriteCostModel finds it cheaper than the original instruction on the target
+ * - Each new instruction is inserted in the proper position in the IR
+ *   and enqueued, so that it can be further simplified (e.g. x << 0)
+ *
+ * @param inst The instruction to be optimized
+ * @param worklist The function worklist, used to replace the instruction and enqueue the new ones
+ * @param costModel Decides whether the new sequence is cheaper than the original instruction
+ * @param ORE The remark emitter of the function
+ * @return true if optimization was applied, false otherwise
+ */
+bool strengthReduction(
+    Instruction &inst,
+    OptimizationWorklist &worklist,
+    const RewriteCostModel &costModel,
+    OptimizationRemarkEmitter &ORE
+) {
+    if (inst.getType()->isFPOrFPVectorTy()) return floatingPointStrengthReduction(inst, worklist, costModel, ORE);
+
+    Value *V = nullptr;
+    const APInt *C = nullptr;   // Scalar constant, or value of a splat vector constant
+    Constant *lanes = nullptr;  // Non uniform vector constant
+    bool isConstantRHS = false;
+
+    if (PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(V), PatternMatch::m_APInt(C)))) {
+        isConstantRHS = true;
+    } else if (PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_APInt(C), PatternMatch::m_Value(V)))) {
+        isConstantRHS = false;
+    } else if (PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(V), PatternMatch::m_Constant(lanes)))) {
+        isConstantRHS = true;
+    } else if (!PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Constant(lanes), PatternMatch::m_Value(V)))) {
+        return false;
+    }
+
+    unsigned int opCode = inst.getOpcode();
+
+    Value *newValue = nullptr;
+    std::string type = "";  // Stores the description of the transformation for the remark
+    InstructionSequence seq(inst, worklist);
+
+    // Handle multiplication operations
+    // The constant is decomposed into a chain of shifts, adds and subs, reusing
+    // the intermediate products when possible. The chain is only emitted if
+    // it is cheap enough to be worth replacing the mul, which is a multi-cycle instruction.
+    if (opCode == Instruction::Mul && lanes) {
+        newValue = emitPowerOf2Lanes(opCode, V, lanes, seq, type);
+    } else if (opCode == Instruction::Mul) {
+        // Multiplications by zero are handled by the algebraic identities
+        if (C->isZero()) return false;
+
+        std::optional<MulChain> chain = findMulChain(*C, MulCostLimit);
+        if (!chain) return false;
+
+        type = "x * c ==> chain of " + std::to_string(chain->cost) + " shift/add/sub instructions";
+
+        newValue = emitMulChain(V, *chain, seq);
+
+        // A multiplication by a positive power of two is a single shift,
+        // which does not wrap if the multiplication did not
+        if (C->isPowerOf2() && !C->isNegative()) {
+            if (BinaryOperator *shift = dyn_cast<BinaryOperator>(newValue)) {
+                shift->setHasNoSignedWrap(inst.hasNoSignedWrap());
+                shift->setHasNoUnsignedWrap(inst.hasNoUnsignedWrap());
+            }
+        }
+    }
+    // Handle division and remainder operations
+    // Only the divisor can be reduced: c / x is left alone
+    else if (
+        (opCode == Instruction::SDiv || opCode == Instruction::UDiv ||
+        opCode == Instruction::SRem || opCode == Instruction::URem) &&
+        isConstantRHS
+    ) {
+        if (lanes) {
+            newValue = emitPowerOf2Lanes(opCode, V, lanes, seq, type);
+        } else {
+            // Divisions by zero are undefined behavior, there is nothing to reduce
+            if (C->isZero()) return false;
+
+            newValue = emitDivisionByConstant(inst, V, *C, seq, type);
+        }
+    }
+
+    if (newValue && !costModel.isProfitable(inst, seq.getInstructions())) return false;
+
+    // If optimization was applied, update all uses of the original instruction
+    if (newValue) {
+        StringRef remarkName;
+
+        if (lanes) {
+            ++NumPowerOf2Lanes;
+            remarkName = "PowerOf2Lanes";
+        } else if (opCode == Instruction::Mul) {
+            ++NumMulChains;
+            remarkName = "MulChain";
+        } else {
+            ++NumDivisionsByConstant;
+            remarkName = "DivisionByConstant";
+        }
+
+        ORE.emit([&]() {
+            return OptimizationRemark("strength-reduction", remarkName, &inst)
+                << "reduced " << ore::NV("Instruction", &inst) << ": " << ore::NV("Transformation", type);
+        });
+
+        seq.commit();
+        worklist.replace(inst, newValue);
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Affine form scale * leaf + offset of an expression tree made of additions,
+ * subtractions, multiplications and left shifts by constants.
+ *
+ * All the arithmetic is modulo 2^width, like the instructions it describes. The flags
+ * record whether the form is also exact in the signed (unsigned) integers: every
+ * instruction of the chain is nsw (nuw) and neither scale nor offset overflowed.
+ */
+struct LinearCombination {
+    Value *leaf = nullptr;
+    APInt scale;
+    APInt offset;
+    SmallVector<Instruction*, 8> chain;     // From the root to the innermost instruction
+    bool isNSW = true;
+    bool isNUW = true;
+};
+
+/**
+ * Matches an instruction that is linear in its non constant operand:
+ * t + C, C + t, t - C, C - t, t * C, C * t and t << C.
+ *
+ * @param inst The instruction to match
+ * @param operand Output parameter holding the non constant operand (t)
+ * @param C Output parameter holding the constant (a splat for vectors)
+ * @param isConstantLHS Output parameter, true if the constant is the left operand
+ * @return true if the instruction is linear
+ */
+bool matchLinearOperation(Instruction &inst, Value *&operand, const APInt *&C, bool &isConstantLHS) {
+    unsigned opCode = inst.getOpcode();
+
+    if (opCode != Instruction::Add && opCode != Instruction::Sub &&
+        opCode != Instruction::Mul && opCode != Instruction::Shl) {
+        return false;
+    }
+
+    if (PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(operand), PatternMatch::m_APInt(C)))) {
+        isConstantLHS = false;
+
+        // Shifts by the bit width or more are poison
+        return opCode != Instruction::Shl || C->ult(C->getBitWidth());
+    }
+
+    if (opCode != Instruction::Shl &&
+        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_APInt(C), PatternMatch::m_Value(operand)))) {
+        isConstantLHS = true;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Collects the linear expression tree rooted at an instruction.
+ *
+ * The tree is followed through the non constant operands as long as they are linear
+ * instructions used only by the tree: an instruction with other users would survive
+ * the rewrite, so folding it would not remove anything.
+ *
+ * @param root The root of the tree
+ * @param worklist The function worklist, used to ignore the users that are already dead
+ * @return The affine form of root, with an empty chain if root is not linear
+ */
+LinearCombination collectLinearCombination(Instruction &root, const OptimizationWorklist &worklist) {
+    LinearCombination combination;
+    Instruction *current = &root;
+    Value *operand = nullptr;
+    const APInt *C = nullptr;
+    bool isConstantLHS = false;
+
+    while (matchLinearOperation(*current, operand, C, isConstantLHS)) {
+        combination.chain.push_back(current);
+        combination.leaf = operand;
+
+        Instruction *next = dyn_cast<Instruction>(operand);
+        if (!next || !worklist.hasOneLiveUser(next)) break;
+
+        current = next;
+    }
+
+    if (combination.chain.empty()) return combination;
+
+    unsigned width = root.getType()->getScalarSizeInBits();
+    combination.scale = APInt(width, 1);
+    combination.offset = APInt(width, 0);
+
+    // The form is built from the innermost instruction, where the tree is just the leaf
+    for (Instruction *inst : reverse(combination.chain)) {
+        matchLinearOperation(*inst, operand, C, isConstantLHS);
+
+        APInt &scale = combination.scale;
+        APInt &offset = combination.offset;
+        bool signedOverflow = false;
+        bool unsignedOverflow = false;
+
+        switch (inst->getOpcode()) {
+            case Instruction::Add:
+                (void) offset.sadd_ov(*C, signedOverflow);
+                offset = offset.uadd_ov(*C, unsignedOverflow);
+            break;
+
+            case Instruction::Sub:
+                if (isConstantLHS) {
+                    // C - (scale * x + offset)
+                    signedOverflow = scale.isMinSignedValue();
+                    bool offsetOverflow = false;
+                    offset = C->ssub_ov(offset, offsetOverflow);
+                    signedOverflow |= offsetOverflow;
+
+                    scale.negate();
+                } else {
+                    offset = offset.ssub_ov(*C, signedOverflow);
+                }
+
+                // A subtraction may make the offset negative, which is only fine for nsw
+                unsignedOverflow = true;
+            break;
+
+            case Instruction::Mul:
+            case Instruction::Shl: {
+                APInt factor = *C;
+                bool factorOverflow = false;
+
+                if (inst->getOpcode() == Instruction::Shl) {
+                    factor = APInt::getOneBitSet(width, C->getZExtValue());
+                    // 2^(width - 1) is negative if read as signed
+                    factorOverflow = factor.isNegative();
+                }
+
+                bool scaleOverflow = false;
+                bool offsetOverflow = false;
+
+                (void) scale.smul_ov(factor, scaleOverflow);
+                (void) offset.smul_ov(factor, offsetOverflow);
+                signedOverflow = factorOverflow || scaleOverflow || offsetOverflow;
+
+                scale = scale.umul_ov(factor, scaleOverflow);
+                offset = offset.umul_ov(factor, offsetOverflow);
+                unsignedOverflow = scaleOverflow || offsetOverflow;
+            }
+            break;
+        }
+
+        combination.isNSW &= inst->hasNoSignedWrap() && !signedOverflow;
+        combination.isNUW &= inst->hasNoUnsignedWrap() && !unsignedOverflow;
+    }
+
+    return combination;
+}
+
+/**
+ * Folds the constants of a linear expression tree and re-emits it in its smallest form:
+ * scale * x + offset needs at most a multiplication (or a shift) and an addition.
+ *
+ * For example ((x + 3) + 5) - 2 becomes x + 6, ((x + 5) + 3) - 8 becomes x, and
+ * ((x + 1) * 4) << 1 becomes (x << 3) + 8.
+ *
+ * The new instructions carry the nsw/nuw flags only when the result is a single
+ * instruction and the whole tree was exact (see LinearCombination): its value is
+ * then the value of the root, which did not wrap.
+ *
+ * @param inst The root of the tree
+ * @param worklist The function worklist, used to replace the instruction and mark the tree as dead
+ * @param ORE The remark emitter of the function
+ * @return true if the tree was folded, false if it is already as small as possible
+ */
+bool foldLinearCombination(Instruction &inst, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    LinearCombination combination = collectLinearCombination(inst, worklist);
+
+    // A single instruction is already in its smallest form
+    if (combination.chain.size() < 2) return false;
+
+    const APInt &scale = combination.scale;
+    const APInt &offset = combination.offset;
+    Value *leaf = combination.leaf;
+    Type *type = inst.getType();
+
+    // A multiplication is only emitted in place of another one: otherwise the fold would
+    // undo the strength reduction (e.g. 0 - (x << 4) into x * -16) and the two would never stop
+    bool needsMul = !scale.isZero() && !scale.isOne() && !scale.isAllOnes() && !scale.isPowerOf2();
+    bool hasMul = any_of(combination.chain, [](Instruction *chainInst) {
+        return chainInst->getOpcode() == Instruction::Mul;
+    });
+
+    if (needsMul && !hasMul) return false;
+
+    InstructionSequence seq(inst, worklist);
+    Value *newValue = nullptr;
+
+    if (scale.isZero()) {
+        newValue = ConstantInt::get(type, offset);
+    } else if (scale.isOne()) {
+        newValue = offset.isZero() ? leaf : seq.binOp(Instruction::Add, leaf, offset);
+    } else if (scale.isAllOnes()) {
+        newValue = seq.binOp(Instruction::Sub, ConstantInt::get(type, offset), leaf);
+    } else {
+        newValue = scale.isPowerOf2() ?
+            seq.binOp(Instruction::Shl, leaf, APInt(scale.getBitWidth(), scale.logBase2())) :
+            seq.binOp(Instruction::Mul, leaf, scale);
+
+        if (!offset.isZero()) {
+            newValue = seq.binOp(Instruction::Add, newValue, offset);
+        }
+    }
+
+    ArrayRef<Instruction*> newInsts = seq.getInstructions();
+
+    if (newInsts.size() >= combination.chain.size()) return false;
+
+    if (newInsts.size() == 1) {
+        // 0 - x and x << (width - 1) wrap even when the multiplication they replace does not
+        newInsts[0]->setHasNoSignedWrap(combination.isNSW && !(scale.isPowerOf2() && scale.isNegative()));
+        newInsts[0]->setHasNoUnsignedWrap(combination.isNUW && !scale.isAllOnes());
+    }
+
+    ++NumLinearFolds;
+
+    ORE.emit([&]() {
+        return OptimizationRemark("multi-instruction", "LinearFold", &inst)
+            << "folded " << ore::NV("Instructions", static_cast<unsigned>(combination.chain.size()))
+            << " instructions into " << ore::NV("Scale", toString(scale, 10, true)) << " * x + "
+            << ore::NV("Offset", toString(offset, 10, true));
+    });
+
+    // The root is replaced, the rest of the chain has no other users and dies with it
+    for (Instruction *chainInst : combination.chain) {
+        worklist.markDead(chainInst);
+    }
+
+    seq.commit();
+    worklist.replace(inst, newValue);
+
+    return true;
+}
+
+/**
+ * Checks whether an operation undoes another one with the same constant, without
+ * losing information.
+ *
+ * The inner operation must not have lost any bit, which is guaranteed by its flags:
+ * (x << c) >> c = x only if no bit is shifted out (shl nuw for lshr, shl nsw for ashr),
+ * (x / c) * c = x only if the division is exact, (x * c) / c = x only if the
+ * multiplication did not wrap, and so on.
+ *
+ * @param outerOpCode The opcode of the inverse operation
+ * @param inner The instruction to undo
+ * @return true if the outer operation gives back the operand of inner
+ */
+bool isLosslessInverse(unsigned outerOpCode, Instruction &inner) {
+    switch (outerOpCode) {
+        case Instruction::Shl:
+            return (inner.getOpcode() == Instruction::LShr || inner.getOpcode() == Instruction::AShr) &&
+                inner.isExact();
+
+        case Instruction::LShr:
+            return inner.getOpcode() == Instruction::Shl && inner.hasNoUnsignedWrap();
+
+        case Instruction::AShr:
+            return inner.getOpcode() == Instruction::Shl && inner.hasNoSignedWrap();
+
+        case Instruction::Mul:
+            return (inner.getOpcode() == Instruction::UDiv || inner.getOpcode() == Instruction::SDiv) &&
+                inner.isExact();
+
+        case Instruction::UDiv:
+            return inner.getOpcode() == Instruction::Mul && inner.hasNoUnsignedWrap();
+
+        case Instruction::SDiv:
+            return inner.getOpcode() == Instruction::Mul && inner.hasNoSignedWrap();
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * Cancels an operation with the inner operation it undoes:
+ * - (x << c) >> c = x and (x >> c) << c = x
+ * - (x * c) / c = x and (x / c) * c = x
+ *
+ * Additions, subtractions and chains of multiplications are folded by foldLinearCombination().
+ *
+ * @param inst The outer operation
+ * @param worklist The function worklist, used to replace the instruction and mark the inner one as dead
+ * @param ORE The remark emitter of the function
+ * @return true if the pair was canceled
+ */
+bool cancelInversePair(Instruction &inst, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    Value *V = nullptr;
+    const APInt *C = nullptr;
+
+    if (!PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(V), PatternMatch::m_APInt(C))) &&
+        !(inst.getOpcode() == Instruction::Mul &&
+        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_APInt(C), PatternMatch::m_Value(V))))) {
+        return false;
+    }
+
+    Instruction *inner = dyn_cast<Instruction>(V);
+    Value *x = nullptr;
+    const APInt *innerC = nullptr;
+
+    if (
+        !inner ||
+        !isLosslessInverse(inst.getOpcode(), *inner) ||
+        !(PatternMatch::match(inner, PatternMatch::m_BinOp(PatternMatch::m_Value(x), PatternMatch::m_APInt(innerC))) ||
+        (inner->getOpcode() == Instruction::Mul &&
+        PatternMatch::match(inner, PatternMatch::m_BinOp(PatternMatch::m_APInt(innerC), PatternMatch::m_Value(x))))) ||
+        *innerC != *C
+    ) {
+        return false;
+    }
+
+    ++NumInversePairs;
+
+    ORE.emit([&]() {
+        return OptimizationRemark("multi-instruction", "InversePair", &inst)
+            << "canceled " << ore::NV("Instruction", &inst) << " with its inverse "
+            << ore::NV("Inverse", inner);
+    });
+
+    // The inner instruction is kept if still used elsewhere
+    worklist.markDead(inner);
+    worklist.replace(inst, x);
+
+    return true;
+}
+
+/**
+ * Folds the constants of two chained floating point operations:
+ * - (x * c1) * c2 = x * (c1 * c2), if both multiplications allow reassociation (reassoc)
+ * - (x + c1) + c2 = x + (c1 + c2), if both additions allow reassociation and
+ *   ignore the sign of zeros (reassoc nsz)
+ *
+ * Reassociating changes the rounding, which is what reassoc allows, but the folded
+ * constant must still be finite and, for multiplications, different from zero
+ * (e.g. 1e300 * 1e300 would turn a finite x * 1e300 * 1e-300 into an infinity).
+ * The new instruction keeps the fast-math flags common to the two operations.
+ *
+ * @param inst The outer operation
+ * @param worklist The function worklist, used to replace the instruction and mark the inner one as dead
+ * @param ORE The remark emitter of the function
+ * @return true if the constants were folded
+ */
+bool foldFPConstantChain(Instruction &inst, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    unsigned opCode = inst.getOpcode();
+
+    if (opCode != Instruction::FMul && opCode != Instruction::FAdd) return false;
+
+    FPFlagRequirement requiredFlags = opCode == Instruction::FMul ?
+        FPFlagRequirement::AllowReassoc : FPFlagRequirement::AllowReassoc | FPFlagRequirement::NoSignedZeros;
+
+    // Commutative operations: the constant can be on either side
+    auto matchConstantOperand = [&](Instruction &I, Value *&V, const APFloat *&C) {
+        return I.getOpcode() == opCode && (
+            PatternMatch::match(&I, PatternMatch::m_BinOp(PatternMatch::m_Value(V), PatternMatch::m_APFloat(C))) ||
+            PatternMatch::match(&I, PatternMatch::m_BinOp(PatternMatch::m_APFloat(C), PatternMatch::m_Value(V)))
+        );
+    };
+
+    Value *V = nullptr;
+    const APFloat *outerC = nullptr;
+
+    if (!hasRequiredFlags(inst, requiredFlags) || !matchConstantOperand(inst, V, outerC)) return false;
+
+    Instruction *inner = dyn_cast<Instruction>(V);
+    Value *x = nullptr;
+    const APFloat *innerC = nullptr;
+
+    if (
+        !inner ||
+        !worklist.hasOneLiveUser(inner) ||
+        !hasRequiredFlags(*inner, requiredFlags) ||
+        !matchConstantOperand(*inner, x, innerC)
+    ) {
+        return false;
+    }
+
+    APFloat folded = *innerC;
+    APFloat::opStatus status = opCode == Instruction::FMul ?
+        folded.multiply(*outerC, APFloat::rmNearestTiesToEven) :
+        folded.add(*outerC, APFloat::rmNearestTiesToEven);
 
-    int nBits = floor(log2(n)) + 1;
+    if ((status & APFloat::opInvalidOp) || !folded.isFinite()) return false;
+    if (opCode == Instruction::FMul && folded.isZero()) return false;
 
-    int res = n;
+    BinaryOperator *newInst = BinaryOperator::Create(
+        static_cast<Instruction::BinaryOps>(opCode), x, ConstantFP::get(inst.getType(), folded), "", &inst);
+    FastMathFlags flags = inst.getFastMathFlags();
+    flags &= inner->getFastMathFlags();
+    newInst->setFastMathFlags(flags);
 
-    for (int i = 0; i < nBits; i++) {
-        if (res % 2 == 1) {
-            expSet.insert(i);
-        }
+    ++NumFPReassociations;
 
-        res /= 2;
-    }
+    ORE.emit([&]() {
+        return OptimizationRemark("multi-instruction", "FPConstantChain", &inst)
+            << "folded the constants of " << ore::NV("Instruction", &inst) << " and "
+            << ore::NV("Inner", inner);
+    });
 
-    return expSet;
-};
+    worklist.markDead(inner);
+    worklist.replace(inst, newInst);
+
+    return true;
+}
 
 /**
- * Optimize instructions based on algebraic identities.
+ * Optimizes across multiple instructions, folding chains of operations by constants.
  *
- * This function recognizes and applies common algebraic simplification rules
- * to reduce computation overhead. It handles several categories of identities:
+ * Two optimizations are applied:
  *
- * Zero-based identities:
- * - x - x = 0, x ^ x = 0 (resulting in constant zero)
- * - x * 0 = 0 (multiplication by zero)
+ * 1. Linear combinations (see foldLinearCombination()):
+ *    - ((x + 3) + 5) - 2 = x + 6
+ *    - (x + c1) - c1 = x, (x - c1) + c1 = x
+ *    - ((x + 5) + 3) - 8 = x
+ *    - ((x * 3) + 1) * 4 = (x * 12) + 4
  *
- * Identity operations:
- * - x + 0 = x, x - 0 = x, x << 0 = x, x >> 0 = x, x ^ 0 = x (no effect)
- * - x & x = x, x | x = x (idempotent operations)
- * - x / x = 1 (division by self)
- * - x * 1 = x, x / 1 = x (multiplication/division by one)
+ * 2. Inverse pairs (see cancelInversePair()):
+ *    - (x << c1) >> c1 = x, (x >> c1) << c1 = x
+ *    - (x * c1) / c1 = x, (x / c1) * c1 = x
+ *    Shifts, multiplications and divisions are only undone when their flags (nsw, nuw,
+ *    exact) guarantee that no information was lost, see isLosslessInverse().
  *
- * Implementation details:
- * - Uses LLVM's pattern matchers to identify binary operations with constants
- * - Handles both cases where constant is on left or right side
- * - Provides verbose output showing the identity that was applied
- * - Replaces the original instruction with the simplified value
+ * Vector operations are handled when their constants are splats. Floating point
+ * operations only fold their constants when reassociation is allowed, see foldFPConstantChain().
  *
- * @param inst The instruction to be optimized
- * @return true if the instruction was optimized (and marked for removal), false otherwise
+ * @param inst The instruction to be optimized (usually the final operation in a sequence)
+ * @param worklist The function worklist, used to replace the instruction and mark the chain as dead
+ * @param ORE The remark emitter of the function
+ * @return true if optimization was applied, false otherwise
  */
-bool algebraicIdentityOptimization(Instruction &inst) {
-    Value *LHS = nullptr;
-    Value *RHS = nullptr;
-    ConstantInt *C = nullptr;
-
-    // Matches if the operation is a binary operation
-    // I've used this approach instead of the simpler inst.isBinaryOp() because
-    // this allow to easily separate the constant and the value, avoiding further checks on the types
-    if (
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(LHS), PatternMatch::m_ConstantInt(C))) ||
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_ConstantInt(C), PatternMatch::m_Value(LHS))) ||
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(LHS), PatternMatch::m_Value(RHS)))
-    ) {
-        unsigned int opCode = inst.getOpcode();  // Operation code (Add, Sub, etc.)
-
-        int64_t constantValue = 0;
-        if (C) constantValue = C->getSExtValue();
-        Value *newValue = nullptr;  // Will hold the simplified value if optimization applies
-
-        std::string identity = "";  // Stores the description of the applied identity for verbose output
-
-        static const std::vector<int> zeroConstantOps = {
-            Instruction::Add,
-            Instruction::Sub,
-            Instruction::Shl,
-            Instruction::LShr,
-            Instruction::And,
-            Instruction::Xor,
-            Instruction::Or,
-        };
-
-        static const std::vector<int> oneConstantOps = {
-            Instruction::Mul,
-            Instruction::UDiv,
-            Instruction::SDiv,
-        };
-
-        if (
-            (C && constantValue == 0 && opCode == Instruction::Mul) ||
-            ((LHS == RHS) && (opCode == Instruction::Sub || opCode == Instruction::Xor))
-        ) {
-            newValue = Constant::getNullValue(inst.getType());
-        } else if (
-            !(C && opCode == Instruction::Sub && C == inst.getOperand(0)) && // if the instruction is of the type y = 0 - x it should not be applied
-            ((C && (constantValue == 0 || constantValue == -1) && std::find(zeroConstantOps.begin(), zeroConstantOps.end(), opCode) != zeroConstantOps.end()) ||
-            (C && constantValue == 1 && std::find(oneConstantOps.begin(), oneConstantOps.end(), opCode) != oneConstantOps.end()) ||
-            ((LHS == RHS) && (opCode == Instruction::And || opCode == Instruction::Or)))
-        ) {
-            newValue = LHS;
-        } else if ((LHS == RHS) && (opCode == Instruction::SDiv || opCode == Instruction::UDiv)) {
-                newValue = ConstantInt::get(inst.getType(), 1);
-        } else {
-            return false;
-        }
-
-        if (LocalOptsVerbose) {
-            static const std::map<int, std::string> constantIdentities {
-                {Instruction::Add, "x + 0 = x"},
-                {Instruction::Sub, "x - 0 = x"},
-                {Instruction::Mul, "x * 1 = x"},
-                {Instruction::Shl, "x << 0 = x"},
-                {Instruction::LShr, "x >> 0 = x"},
-                {Instruction::Xor, "x ^ 0 = x"},
-                {Instruction::And, "x & 0 = 0"},
-                {Instruction::SDiv, "x / 1 = x"},
-                {Instruction::UDiv, "x / 1 = x"}
-            };
-
-            static const std::map<int, std::string> nonConstantIdentities {
-                {Instruction::Sub, "x - x = 0"},
-                {Instruction::And, "x & x = x"},
-                {Instruction::Or, "x | x = x"},
-                {Instruction::Xor, "x ^ x = 0"},
-                {Instruction::SDiv, "x / 1 = x"},
-                {Instruction::UDiv, "x / 1 = x"}
-            };
-
-            if (C && C->getSExtValue() == 0 && opCode == Instruction::Mul) {
-                identity = "x * 0 = 0";
-            } else if (C && C->getSExtValue() == -1 && opCode == Instruction::And) {
-                identity = "x & -1 = x";
-            } else if (C) {
-                identity = constantIdentities.at(opCode);
-            } else {
-                identity = nonConstantIdentities.at(opCode);
-            }
-        }
-
-        // If we found an optimization, apply it
-        if (newValue) {
-            if (LocalOptsVerbose) {
-                outs() << "Applying Algebraic identity optimization on instruction: " << inst << "\n";
-                outs() << "The identity found was of the type: " << identity << "\n\n";
-            }
-
-            // Replace all uses of the original instruction with the new optimized value
-            inst.replaceAllUsesWith(newValue);
-
-            return true;
-        }
-    }
+bool multiInstructionOptimization(Instruction &inst, OptimizationWorklist &worklist, OptimizationRemarkEmitter &ORE) {
+    if (inst.getType()->isFPOrFPVectorTy()) return foldFPConstantChain(inst, worklist, ORE);
 
-    return false;
+    return foldLinearCombination(inst, worklist, ORE) || cancelInversePair(inst, worklist, ORE);
 }
 
 /**
- * Apply strength reduction optimizations to convert expensive operations to cheaper ones.
+ * Apply specified optimizations to a single instruction.
  *
- * Strength reduction replaces computationally expensive operations with equivalent but
- * more efficient sequences. This optimization targets:
+ * This function dispatches the instruction to the optimizations selected
+ * by the type parameter:
  *
- * 1. Multiplication by power of 2:
- *    - x * 2^n becomes x << n (left shift is faster than multiplication)
+ * 1. Algebraic Identity Optimizations - simplify based on mathematical rules
+ * 2. Idiom Recognition - replace bit manipulation idioms with intrinsics
+ * 3. Compare Folding - fold comparisons against constants and selects with a known result
+ * 4. Strength Reduction - replace expensive operations with cheaper ones
+ * 5. Multi-Instruction Optimization - eliminate sequences of inverse operations
+ * 6. All Optimizations - apply all available optimizations in sequence,
+ *    stopping at the first one that rewrites the instruction
+ *
+ * Floating point operations, scalar or vector, go through the floating point version of
+ * each optimization, which only applies the rewrites allowed by their fast-math flags.
  *
- * 2. Multiplication by specific patterns:
- *    - For constants like 2^n-1 (e.g., 7, 15): x * c becomes (x << n) - x
- *    - For constants with few set bits: decomposes multiplication into a series of shifts and adds
- *      (e.g., x * 10 becomes (x << 3) + (x << 1) since 10 = 2^3 + 2^1)
+ * @param inst The instruction to optimize
+ * @param type The specific optimization type to apply (ALGEBRAIC, IDIOM, COMPARE, STRENGTH, MULTI, or ALL)
+ * @param worklist The function worklist
+ * @param costModel The cost model of the function, used by the rewrites creating new instructions
+ * @param ORE The remark emitter of the function
+ * @return true if the instruction was rewritten
+ */
+bool runOnInstructionOptimizations(
+    Instruction &inst,
+    opt type,
+    OptimizationWorklist &worklist,
+    const RewriteCostModel &costModel,
+    OptimizationRemarkEmitter &ORE
+) {
+    switch (type) {
+        case ALGEBRAIC:
+            return algebraicIdentityOptimization(inst, worklist, ORE);
+
+        case IDIOM:
+            return idiomRecognition(inst, worklist, ORE);
+
+        case COMPARE:
+            return compareFolding(inst, worklist, ORE);
+
+        case STRENGTH:
+            return strengthReduction(inst, worklist, costModel, ORE);
+
+        case MULTI:
+            return multiInstructionOptimization(inst, worklist, ORE);
+
+        case ALL:
+            return algebraicIdentityOptimization(inst, worklist, ORE) ||
+                idiomRecognition(inst, worklist, ORE) ||
+                compareFolding(inst, worklist, ORE) ||
+                strengthReduction(inst, worklist, costModel, ORE) ||
+                multiInstructionOptimization(inst, worklist, ORE);
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * Run specified optimization passes on a function until a fixed point is reached.
  *
- * 3. Division by power of 2:
- *    - x / 2^n becomes x >> n (right shift is faster than division)
+ * Every instruction of the function is enqueued in an OptimizationWorklist, following
+ * the program order. Instructions are then popped and optimized one at a time: each
+ * rewrite enqueues again the users of the rewritten instruction and the newly created
+ * instructions, so optimizations enabled by previous rewrites are applied without
+ * re-running the pass. When the worklist is empty, the instructions replaced by the
+ * optimizations are erased in bulk.
  *
- * Implementation details:
- * - Uses getExpSet() to decompose constants into their binary components
- * - For constants with all bits set (2^n-1), applies the (x << n) - x optimization
- * - For constants with few set bits (<=3), creates a sequence of shift and add operations
- * - Handles negative constants by negating the final result
- * - Each new instruction is inserted in the proper position in the IR
+ * Note: This approach is more targeted than general Dead Code Elimination,
+ * as it only removes instructions that our specific optimizations have replaced.
  *
- * @param inst The instruction to be optimized
- * @return true if optimization was applied, false otherwise
+ * @param F The LLVM Function to optimize
+ * @param type The specific optimization type to apply (ALGEBRAIC, IDIOM, COMPARE, STRENGTH, MULTI, or ALL)
+ * @param FAM The function analysis manager, providing the TargetTransformInfo, the block
+ *            frequencies and the remark emitter of F
+ * @param PSI The profile summary of the module
+ * @return true if the function was transformed
  */
-bool strengthReduction(Instruction &inst) {
-    Value *V = nullptr;
-    ConstantInt *C = nullptr;
+bool runOnFunction(Function &F, opt type, FunctionAnalysisManager &FAM, ProfileSummaryInfo &PSI) {
+    bool Transformed = false;
+    OptimizationWorklist worklist;
+    OptimizationRemarkEmitter &ORE = FAM.getResult<OptimizationRemarkEmitterAnalysis>(F);
 
-    if (
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(V), PatternMatch::m_ConstantInt(C))) ||
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_ConstantInt(C), PatternMatch::m_Value(V)))
-    ) {
-        unsigned int opCode = inst.getOpcode();
+    // Block frequencies are only meaningful (and worth computing) with a profile
+    BlockFrequencyInfo *BFI = PSI.hasProfileSummary() && !F.isDeclaration() ?
+        &FAM.getResult<BlockFrequencyAnalysis>(F) : nullptr;
 
-        Instruction *newInst = nullptr;
-        int64_t constantValue = C->getSExtValue();
+    RewriteCostModel costModel(
+        FAM.getResult<TargetIRAnalysis>(F), ORE, BFI, &PSI, !F.getParent()->getTargetTriple().empty());
 
-        bool isNegative = constantValue < 0;
+    LLVM_DEBUG(dbgs() << "--- Function " << F.getName() << " OPTIMIZATIONS ---\n");
 
-        if (isNegative) {
-            constantValue *= -1;
+    // The worklist is a stack, so instructions are pushed in reverse order
+    // in order to pop them following the program order
+    for (BasicBlock &BB : reverse(F)) {
+        for (Instruction &inst : reverse(BB)) {
+            worklist.push(&inst);
         }
+    }
 
-        std::string type = "";  // Stores the description of the transformation for verbose output
-
-        // Handle multiplication operations
-        // The number is converted to binary and a set with the exponents to use is created.
-        // If the constant has a binary is equal to 2^(n-1)
-        // the optimization x << c - x is applied
-        // Otherwise the strength reduction is applied by converting the multiplication into a sum of V with different powers of two.
-        if (opCode == Instruction::Mul) {
-            std::set<int> expSet = getExpSet(constantValue);
-            int nBits = floor(log2(constantValue)) + 1;
-
-            Instruction *prevInst = &inst;
+    while (Instruction *inst = worklist.pop()) {
+        if (runOnInstructionOptimizations(*inst, type, worklist, costModel, ORE)) {
+            Transformed = true;
+        }
+    }
 
-            if (expSet.size() == nBits) {
-                type = "(x << c) - x";
-                Instruction *newInstShift = BinaryOperator::Create(
-                    Instruction::Shl, V, ConstantInt::get(Type::getInt32Ty(inst.getParent()->getContext()), nBits));
+    worklist.eraseDeadInstructions();
 
-                newInstShift->insertAfter(prevInst);
+    return Transformed;
+}
 
-                Instruction *newInstSub = BinaryOperator::CreateNSWSub(
-                    newInstShift, V);
+/**
+ * Key of the CSE hash table, wrapping an instruction without side effects.
+ *
+ * Two keys are equal when their instructions compute the same value: same opcode,
+ * type, flags (nsw, nuw, exact, fast-math) and operands, also with the operands swapped
+ * for commutative operations and comparisons (with the swapped predicate).
+ */
+struct CSEKey {
+    Instruction *inst;
+
+    CSEKey(Instruction *inst) : inst(inst) {}
+
+    /**
+     * Returns true if the instruction can be replaced by an identical one dominating it.
+     * Loads, calls and the other instructions touching memory are excluded, since an
+     * identical instruction may produce a different value.
+     */
+    static bool canHandle(Instruction *inst) {
+        return isa<BinaryOperator>(inst) || isa<CmpInst>(inst) || isa<CastInst>(inst) ||
+            isa<SelectInst>(inst) || isa<GetElementPtrInst>(inst) || isa<UnaryOperator>(inst) ||
+            isa<ExtractElementInst>(inst) || isa<InsertElementInst>(inst) || isa<ShuffleVectorInst>(inst);
+    }
+};
 
-                newInstSub->insertAfter(newInstShift);
+namespace llvm {
+    template <> struct DenseMapInfo<CSEKey> {
+        static inline CSEKey getEmptyKey() {
+            return DenseMapInfo<Instruction*>::getEmptyKey();
+        }
 
-                newInst = newInstSub;
-            } else if (expSet.size() < 4) {
-                // I've decided to not apply strength reduction optimization if the number of shifts to add is more than 3.
-                // Even though the mul instruction is a multi-cycle instruction, replacing it with multiple shifts and adds can
-                // become more expensive than the mul itself.
-                // My choice is arbitrary and it is based on simple web researchs, therefore
-                // I don't consider it as the perfect solution and it, perharps, could be improved; however I consider it a good trade-off
+        static inline CSEKey getTombstoneKey() {
+            return DenseMapInfo<Instruction*>::getTombstoneKey();
+        }
 
-                type = "x * c = x * (2^c1 + 2^c2 ...) ==> x << c1 + x << c2 ...";
-                for (int exp : expSet) {
-                    Instruction *newInstShift = BinaryOperator::Create(
-                        Instruction::Shl, V, ConstantInt::get(Type::getInt32Ty(inst.getParent()->getContext()), exp));
+        static bool isSentinel(const CSEKey &key) {
+            return key.inst == getEmptyKey().inst || key.inst == getTombstoneKey().inst;
+        }
 
-                    newInstShift->insertAfter(prevInst);
+        static unsigned getHashValue(const CSEKey &key) {
+            Instruction *inst = key.inst;
 
-                    if (expSet.size() > 1 && prevInst != &inst) {
-                        Instruction *newInstAdd = nullptr;
+            if (inst->getNumOperands() == 2) {
+                Value *LHS = inst->getOperand(0);
+                Value *RHS = inst->getOperand(1);
+                unsigned kind = 0;
 
-                        newInstAdd = BinaryOperator::CreateNSWAdd(
-                            newInstShift, prevInst);
+                // Operands are hashed in a canonical order, so that x + y and y + x collide
+                if (CmpInst *cmp = dyn_cast<CmpInst>(inst)) {
+                    kind = cmp->getPredicate();
 
-                        newInstAdd->insertAfter(newInstShift);
-                        prevInst = newInstAdd;
-                    } else {
-                        prevInst = newInstShift;
+                    if (LHS > RHS) {
+                        std::swap(LHS, RHS);
+                        kind = cmp->getSwappedPredicate();
                     }
+                } else if (inst->isCommutative() && LHS > RHS) {
+                    std::swap(LHS, RHS);
                 }
 
-                newInst = prevInst;
-            } else {
-                return false;
+                return hash_combine(inst->getOpcode(), inst->getType(), inst->getRawSubclassOptionalData(), kind, LHS, RHS);
             }
-       }
-        // Handle division operations
-        else if (opCode == Instruction::SDiv || opCode == Instruction::UDiv) {
-            if ((constantValue & (constantValue - 1)) == 0) {
-                // If divisor is a power of 2, replace division with right shift
-                // x / 2^n => x >> n
-                type = "x / 2^n ==> x >> n";
-                newInst = BinaryOperator::Create(
-                    Instruction::LShr, V, ConstantInt::get(inst.getType(), log2(constantValue)));
-                newInst->insertAfter(&inst);
-            }
-        }
 
-        if (isNegative) {
-            Instruction *negInst = BinaryOperator::CreateNSWSub(ConstantInt::get(inst.getType(), 0), newInst, "neg");
-            negInst->insertAfter(newInst);
-            newInst = negInst;
+            return hash_combine(
+                inst->getOpcode(),
+                inst->getType(),
+                inst->getRawSubclassOptionalData(),
+                hash_combine_range(inst->value_op_begin(), inst->value_op_end())
+            );
         }
 
-        // If optimization was applied, update all uses of the original instruction
-        if (newInst) {
-            if (LocalOptsVerbose) {
-                outs() << "Applying Strength Reduction optimization on instruction: " << inst << "\n";
-                outs() << "The transformation applied was: " << type << "\n\n";
+        static bool isEqual(const CSEKey &LHS, const CSEKey &RHS) {
+            if (isSentinel(LHS) || isSentinel(RHS)) return LHS.inst == RHS.inst;
+
+            Instruction *first = LHS.inst;
+            Instruction *second = RHS.inst;
+
+            if (first->isIdenticalTo(second)) return true;
+
+            if (first->getOpcode() != second->getOpcode() || first->getType() != second->getType()) return false;
+
+            if (first->isCommutative()) {
+                return first->getRawSubclassOptionalData() == second->getRawSubclassOptionalData() &&
+                    first->getOperand(0) == second->getOperand(1) &&
+                    first->getOperand(1) == second->getOperand(0);
             }
 
-            inst.replaceAllUsesWith(newInst);
+            if (CmpInst *firstCmp = dyn_cast<CmpInst>(first)) {
+                CmpInst *secondCmp = cast<CmpInst>(second);
 
-            return true;
-        }
-    }
+                return firstCmp->getRawSubclassOptionalData() == secondCmp->getRawSubclassOptionalData() &&
+                    firstCmp->getPredicate() == secondCmp->getSwappedPredicate() &&
+                    firstCmp->getOperand(0) == secondCmp->getOperand(1) &&
+                    firstCmp->getOperand(1) == secondCmp->getOperand(0);
+            }
 
-    return false;
-}
+            return false;
+        }
+    };
+} // namespace llvm
 
 /**
- * Optimizes across multiple instructions by recognizing and eliminating inverse operations.
- *
- * This optimization identifies sequences of instructions where operations cancel each other out,
- * with a focus on patterns like:
- * - (x + c1) - c1 = x  (addition followed by subtraction of same constant)
- * - (x - c1) + c1 = x  (subtraction followed by addition of same constant)
- * - (x << c1) >> c1 = x  (left shift followed by right shift of same constant)
- * - (x >> c1) << c1 = x  (right shift followed by left shift of same constant)
- * - (x * c1) / c1 = x  (multiplication followed by division with same constant)
- * - (x / c1) * c1 = x  (division followed by multiplication with same constant)
+ * Removes the redundant instructions of a function (common subexpression elimination).
  *
- * Implementation algorithm:
- * 1. Start with a binary operation (e.g., sub, add) with a constant operand
- * 2. Check if its variable operand is also a binary operation
- * 3. Use a worklist to traverse a chain of operations, building a list of specular instructions
- * 4. Track accumulating constant values to detect when operations cancel out
- * 5. For add/sub: check if constants sum to zero
- * 6. For mul/div: check if constants divide to 1
- * 7. For shift operations: check if shift amounts cancel out
+ * The dominator tree is visited depth-first with a scoped hash table: the instructions
+ * of a block are inserted in a scope which stays open while the blocks it dominates are
+ * visited, and is closed afterwards. An instruction identical to one in the table is
+ * therefore always dominated by it, and all its uses can be replaced.
  *
- * Complex patterns like ((x + 5) + 3) - 8 = x are handled by recursively analyzing the
- * instruction chain.
+ * Instructions are visited in program order and replaced immediately, so whole sequences
+ * are removed in one walk: once two shl x, 2 are merged, the two adds using them become
+ * identical as well (e.g. the chains created by the strength reduction for two x * 45).
  *
- * When a cancellation pattern is found, the entire chain is replaced with the original
- * variable, and unused instructions are marked for removal.
- *
- * @param inst The instruction to be optimized (usually the final operation in a sequence)
- * @param instructionsToRemove Vector storing instructions to be removed after optimization
- * @return true if optimization was applied, false otherwise
+ * @param F The function to optimize
+ * @param DT The dominator tree of F
+ * @param ORE The remark emitter of F
+ * @return true if at least one instruction was removed
  */
-bool multiInstructionOptimization(Instruction &inst, std::vector<Instruction*> &instructionsToRemove) {
-    Value *V = nullptr;
-    ConstantInt *C = nullptr;
+bool eliminateCommonSubexpressions(Function &F, DominatorTree &DT, OptimizationRemarkEmitter &ORE) {
+    typedef ScopedHashTable<CSEKey, Instruction*, DenseMapInfo<CSEKey>> CSETable;
+    typedef ScopedHashTableScope<CSEKey, Instruction*, DenseMapInfo<CSEKey>> CSEScope;
+
+    /**
+     * A node of the dominator tree under visit, with its scope and the next child to visit
+     */
+    struct StackNode {
+        DomTreeNode *node;
+        DomTreeNode::const_iterator nextChild;
+        CSEScope scope;
+
+        StackNode(CSETable &table, DomTreeNode *node) :
+            node(node), nextChild(node->begin()), scope(table) {}
+    };
 
-    if (
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(V), PatternMatch::m_ConstantInt(C))) ||
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_ConstantInt(C), PatternMatch::m_Value(V)))
-    ) {
-        unsigned int opCode = inst.getOpcode();
-        int64_t constantValue = C->getSExtValue();
+    bool transformed = false;
+    CSETable table;
+    std::vector<std::unique_ptr<StackNode>> stack;
 
-        Instruction *varInst = dyn_cast<Instruction>(V);
-        // Ensure the variable operand is also a binary instruction
-        if (!varInst || !varInst->isBinaryOp()) {
-            return false;
-        }
+    LLVM_DEBUG(dbgs() << "--- Function " << F.getName() << " CSE ---\n");
 
-        // Define pairs of inverse operations
-        static const std::map<int, int> opMap {
-            {Instruction::Add, Instruction::Sub},
-            {Instruction::Sub, Instruction::Add},
-            {Instruction::Shl, Instruction::LShr},
-            {Instruction::LShr, Instruction::Shl},
-            {Instruction::Mul, Instruction::SDiv},
-            {Instruction::UDiv, Instruction::Mul},
-            {Instruction::SDiv, Instruction::Mul}
-        };
-
-        std::queue<Instruction*> worklist;
-        worklist.push(varInst);
-
-        std::vector<Instruction*> specular_inst;
-        specular_inst.push_back(varInst);
-
-        Value* varV = nullptr;
-        ConstantInt* varC = nullptr;
-        bool canOptimize = false;
-
-        while (!worklist.empty()) {
-            varInst = worklist.front();
-            worklist.pop();
-            int varOpcode = varInst->getOpcode();
-
-            if (
-                (PatternMatch::match(varInst, PatternMatch::m_BinOp(PatternMatch::m_Value(varV), PatternMatch::m_ConstantInt(varC))) ||
-                PatternMatch::match(varInst, PatternMatch::m_BinOp(PatternMatch::m_ConstantInt(varC), PatternMatch::m_Value(varV)))) &&
-                (opMap.at(opCode) == varOpcode || opCode == varOpcode)
-            ) {
-                bool areDiscordant = false;
-
-                // This if checks whether the operations are of the same type but with negative constants
-                // A further check is done to make sure that the operation is not a logical shift because
-                // it is not allowed to have shifts with negative values
-                if (
-                    constantValue * varC->getSExtValue() < 0 &&
-                    opCode == varOpcode &&
-                    (opCode != Instruction::Add || opCode != Instruction::Sub)
-                ) {
-                    areDiscordant = true;
-                } else if (opCode == varOpcode) {
-                    return false;
-                }
+    stack.push_back(std::make_unique<StackNode>(table, DT.getRootNode()));
+    bool isNewNode = true;
 
-                if (LocalOptsVerbose) {
-                    outs() << "Found potential inverse operation with constant: " << varC->getSExtValue() << "\n";
-                }
+    while (!stack.empty()) {
+        StackNode &current = *stack.back();
 
-                int64_t temp = 0;
-                int64_t rem = 1;
+        // The instructions of a block are processed only the first time its node is on top
+        if (isNewNode) {
+            for (Instruction &inst : make_early_inc_range(*current.node->getBlock())) {
+                if (!CSEKey::canHandle(&inst)) continue;
 
-                if (areDiscordant) {
-                    temp = constantValue + varC->getSExtValue();
-                } else {
-                    if (
-                        (opCode == Instruction::Mul ||
-                        opCode == Instruction::UDiv ||
-                        opCode == Instruction::SDiv) &&
-                        constantValue > varC->getSExtValue()
-                    ) {
-                        temp = constantValue / varC->getSExtValue();
-                        rem = constantValue % varC->getSExtValue();
-                    } else {
-                        temp = constantValue - varC->getSExtValue();
-                    }
-                }
+                if (Instruction *available = table.lookup(&inst)) {
+                    ++NumRedundantInsts;
 
-                if (
-                    temp == 0 ||
-                    (temp == 1 && rem == 0 && (opCode == Instruction::Mul || opCode == Instruction::UDiv || opCode == Instruction::SDiv))
-                ) {
-                    canOptimize = true;
-                } else if (temp > 0) {
-                    if (Instruction *vInst = dyn_cast<Instruction>(varV)) {
-                        worklist.push(vInst);
-                        specular_inst.push_back(vInst);
-                        constantValue = temp;
-                    }
+                    ORE.emit([&]() {
+                        return OptimizationRemark("local-cse", "RedundantInstruction", &inst)
+                            << "removed " << ore::NV("Instruction", &inst) << ", same value as "
+                            << ore::NV("Available", available);
+                    });
+
+                    inst.replaceAllUsesWith(available);
+                    inst.eraseFromParent();
+                    transformed = true;
                 } else {
-                    return false;
+                    table.insert(&inst, &inst);
                 }
             }
         }
 
-        // Check if the current operation and the nested operation are inverse operations
-        if (canOptimize) {
-            if (LocalOptsVerbose) {
-                outs() << "Applying Multi Instruction optimization on instruction: " << inst << "\n";
-                outs() << "This is because, these instructions:\n";
-
-                for (Instruction *inst : specular_inst) {
-                    outs() << "\t";
-                    inst->print(outs());
-                    outs() << "\n";
-                }
-
-                outs() << "are inverse operations that cancel out with the current instruction\n\n";
-            }
-
-            instructionsToRemove.push_back(&inst);
-
-            for (Instruction *inst : specular_inst) {
-                if (inst->hasNUses(1)) {
-                    instructionsToRemove.push_back(inst);
-                } else {
-                    bool canRemove = false;
-
-                    for (User *user : inst->users()) {
-                        if (user == inst ||
-                            find(instructionsToRemove.begin(), instructionsToRemove.end(), user) != instructionsToRemove.end()
-                        ) {
-                            canRemove = true;
-                        }
-                    }
+        if (current.nextChild != current.node->end()) {
+            DomTreeNode *child = *current.nextChild++;
+            stack.push_back(std::make_unique<StackNode>(table, child));
+            isNewNode = true;
+        } else {
+            // Closing the scope removes the instructions of the block from the table
+            stack.pop_back();
+            isNewNode = false;
+        }
+    }
 
-                    if (canRemove) instructionsToRemove.push_back(inst);
-                }
-            }
+    return transformed;
+}
 
-            // If so, we can simplify to just the original variable
-            // For example: (x + 5) - 5 = x or (x * 2) / 2 = x
-            inst.replaceAllUsesWith(varV);
+/**
+ * Checks whether a multiplication takes an affine induction variable of a loop
+ * and a value invariant in the same loop.
+ *
+ * @param inst The multiplication
+ * @param L The loop of the induction variable
+ * @param SE The scalar evolution of the function
+ * @return true if one operand is an induction variable of L and the other is invariant in L
+ */
+bool isInductionTimesInvariant(Instruction &inst, const Loop *L, ScalarEvolution &SE) {
+    const SCEV *LHS = SE.getSCEV(inst.getOperand(0));
+    const SCEV *RHS = SE.getSCEV(inst.getOperand(1));
 
-            return true;
-        }
-    }
+    auto isInduction = [&](const SCEV *S) {
+        const SCEVAddRecExpr *AR = dyn_cast<SCEVAddRecExpr>(S);
+        return AR && AR->isAffine() && AR->getLoop() == L;
+    };
 
-    return false;
+    return (isInduction(LHS) && SE.isLoopInvariant(RHS, L)) || (isInduction(RHS) && SE.isLoopInvariant(LHS, L));
 }
 
 /**
- * Apply specified optimizations to every instruction in a basic block.
+ * Replaces the multiplications of affine induction variables by loop invariant values
+ * with additive recurrences.
  *
- * This function iterates through each instruction in the provided basic block and
- * applies optimizations based on the specified optimization type:
+ * Given the induction variable i = {start, +, step} of a loop L, the product i * k is
+ * the affine recurrence {start * k, +, step * k}: it is computed by a new PHI in the
+ * header of L, starting from start * k and incremented by step * k in the latch, so the
+ * multiplication disappears from the loop body, e.g.
  *
- * 1. Algebraic Identity Optimizations - simplify based on mathematical rules
- * 2. Strength Reduction - replace expensive operations with cheaper ones
- * 3. Multi-Instruction Optimization - eliminate sequences of inverse operations
- * 4. All Optimizations - apply all available optimizations in sequence
+ *   for (i = 0; i < n; i++) a[i * 12] = ...    becomes    for (i = 0, t = 0; i < n; i++, t += 12) a[t] = ...
  *
- * Implementation details:
- * - Skips floating point operations (only optimizes integer operations)
- * - Collects instructions that have been replaced by optimizations
- * - Removes the optimized instructions after all transformations are complete
- * - Provides verbose output about removed instructions when enabled
+ * The start and the step are expanded in the preheader with SCEVExpander, so the
+ * invariant factor can also be a value (e.g. the row size of a matrix). Products with
+ * the same recurrence share the same PHI.
  *
- * Note: This approach is more targeted than general Dead Code Elimination,
- * as it only removes instructions that our specific optimizations have replaced.
+ * Only loops in simplified form (with a preheader and a single latch) are transformed.
+ * The new additions carry no flags: the recurrence gives the same values as the
+ * multiplication modulo 2^width, but it does not inherit the guarantees of its nsw/nuw.
  *
- * @param BB The basic block to optimize
- * @param type The specific optimization type to apply (ALGEBRAIC, STRENGTH, MULTI, or ALL)
- * @return true if any optimization was applied to any instruction
+ * @param F The function to optimize
+ * @param LI The loops of F
+ * @param SE The scalar evolution of F
+ * @param ORE The remark emitter of F
+ * @return true if at least one multiplication was replaced
  */
-bool runOnBBOptimizations(BasicBlock &BB, opt type) {
-    std::vector<Instruction*> instructionsToRemove;
+bool reduceInductionMultiplications(Function &F, LoopInfo &LI, ScalarEvolution &SE, OptimizationRemarkEmitter &ORE) {
+    bool transformed = false;
+    SCEVExpander expander(SE, F.getParent()->getDataLayout(), "iv.sr");
 
-    bool isChanged = false;
+    // In canonical mode the recurrences of outer loops (e.g. a start depending on the outer
+    // induction variable) would be expanded as multiplications of a canonical induction variable
+    expander.disableCanonicalMode();
+    DenseMap<const SCEV*, PHINode*> recurrences;
+    SmallVector<Instruction*, 16> candidates;
 
-    for (Instruction &inst : BB) {
-        if (!inst.getType()->isFloatingPointTy()) {
-            switch (type) {
-                case ALGEBRAIC:
-                    isChanged = algebraicIdentityOptimization(inst);
-                break;
+    // The candidates are collected first, since the rewrites erase instructions
+    for (BasicBlock &BB : F) {
+        if (!LI.getLoopFor(&BB)) continue;
 
-                case STRENGTH:
-                    isChanged = strengthReduction(inst);
-                break;
+        for (Instruction &inst : BB) {
+            if (inst.getOpcode() == Instruction::Mul && SE.isSCEVable(inst.getType())) {
+                candidates.push_back(&inst);
+            }
+        }
+    }
 
-                case MULTI:
-                    isChanged = multiInstructionOptimization(inst, instructionsToRemove);
-                break;
+    for (Instruction *inst : candidates) {
+        const SCEVAddRecExpr *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(inst));
+        if (!AR || !AR->isAffine()) continue;
 
-                case ALL:
-                    isChanged = algebraicIdentityOptimization(inst) ||
-                        strengthReduction(inst) ||
-                        multiInstructionOptimization(inst, instructionsToRemove);
-                break;
+        Loop *L = const_cast<Loop*>(AR->getLoop());
+        BasicBlock *preheader = L->getLoopPreheader();
+        BasicBlock *latch = L->getLoopLatch();
 
-                default:
-                break;
-            }
+        if (!preheader || !latch || !isInductionTimesInvariant(*inst, L, SE)) continue;
 
-            if (isChanged && find(instructionsToRemove.begin(), instructionsToRemove.end(), &inst) == instructionsToRemove.end()) {
-                instructionsToRemove.push_back(&inst);
-            }
-        }
-    }
+        const SCEV *start = AR->getStart();
+        const SCEV *step = AR->getStepRecurrence(SE);
+        Instruction *insertPoint = preheader->getTerminator();
 
+        if (!expander.isSafeToExpandAt(start, insertPoint) || !expander.isSafeToExpandAt(step, insertPoint)) continue;
 
-    /*
-    Note on alternative approach:
-        A full Dead Code Elimination (DCE) pass could be implemented as follows,
-        but it's too aggressive for our targeted optimization purposes.
-        I prefer to only remove instructions that our optimizations have explicitly handled.
+        PHINode *&recurrence = recurrences[AR];
 
-    for (Instruction &inst : BB) {
-        if (inst.isSafeToRemove()) {
-            if (LocalOptsVerbose) {
-                outs() << "Removing instruction: " << inst << "\n";
-            }
+        if (!recurrence) {
+            Type *type = inst->getType();
+            Value *startValue = expander.expandCodeFor(start, type, insertPoint);
+            Value *stepValue = expander.expandCodeFor(step, type, insertPoint);
 
-            inst->eraseFromParent();
-        };
-    }
-    */
+            // In simplified form the header has exactly two predecessors: the preheader and the latch
+            recurrence = PHINode::Create(type, 2, "iv.sr", &L->getHeader()->front());
+            Instruction *next = BinaryOperator::CreateAdd(recurrence, stepValue, "iv.sr.next", latch->getTerminator());
 
-    for (Instruction *inst : instructionsToRemove) {
-        if (LocalOptsVerbose) {
-            outs() << "Removing instruction: ";
-            inst->print(outs());
-            outs() << "\n";
+            recurrence->addIncoming(startValue, preheader);
+            recurrence->addIncoming(next, latch);
+
+            ++NumInductionRecurrences;
         }
 
+        ++NumInductionMuls;
+
+        ORE.emit([&]() {
+            return OptimizationRemark("iv-strength-reduction", "AdditiveRecurrence", inst)
+                << "replaced " << ore::NV("Instruction", inst)
+                << " of an induction variable with an additive recurrence in loop "
+                << ore::NV("Loop", L->getHeader()->getName());
+        });
+
+        SE.forgetValue(inst);
+        inst->replaceAllUsesWith(recurrence);
         inst->eraseFromParent();
+
+        transformed = true;
     }
 
-    return isChanged;
+    return transformed;
 }
 
 /**
- * Run specified optimization passes on every basic block in a function.
- *
- * This function coordinates the optimization process at the function level,
- * iterating through each basic block in the function and applying the
- * selected optimization type. It provides verbose output about the optimization
- * process when enabled.
+ * Applies algebraic identity optimizations to a module.
  *
- * The function serves as an intermediate layer between module-level optimization
- * and basic block-level optimizations, dispatching the appropriate optimization
- * strategy based on the type parameter.
+ * This pass implements algebraic simplification rules to optimize code,
+ * such as x+0=x, x*1=x, etc.
  *
- * @param F The LLVM Function to optimize
- * @param type The specific optimization type to apply (ALGEBRAIC, STRENGTH, MULTI, or ALL)
- * @return true if any basic block was transformed
+ * @param M The LLVM Module to optimize
+ * @param AM The module analysis manager providing analysis results
+ * @return PreservedAnalyses indicating which analyses are preserved after optimization
  */
-bool runOnFunction(Function &F, opt type) {
-    bool Transformed = false;
+PreservedAnalyses AlgebraicIdentity::run(Module &M, ModuleAnalysisManager &AM) {
+    bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    ProfileSummaryInfo &PSI = AM.getResult<ProfileSummaryAnalysis>(M);
 
-    if (LocalOptsVerbose) {
-        outs() << "--- " << "Function " << F.getName() << " OPTIMIZATIONS ---\n\n";
-    }
+    // Run optimizations on each function in the module
+    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter)
+        if (runOnFunction(*Fiter, ALGEBRAIC, FAM, PSI)) {
+            transformed = true;
+        }
 
-    // Iterate over all basic blocks in the function
-    for (auto Iter = F.begin(); Iter != F.end(); ++Iter) {
-        // Apply optimizations to each basic block
-        if (runOnBBOptimizations(*Iter, type)) {
-            Transformed = true;
+    if (transformed)
+        // If any function was modified, invalidate all analyses
+        return PreservedAnalyses::none();
+
+    // If no changes were made, all analyses are preserved
+    return PreservedAnalyses::all();
+}
+
+/**
+ * Replaces the bit manipulation idioms of a module with intrinsics.
+ *
+ * This pass recognizes rotates, population counts, counts of leading zeros
+ * and byte swaps written by hand, see idiomRecognition().
+ *
+ * @param M The LLVM Module to optimize
+ * @param AM The module analysis manager providing analysis results
+ * @return PreservedAnalyses indicating which analyses are preserved after optimization
+ */
+PreservedAnalyses IdiomRecognition::run(Module &M, ModuleAnalysisManager &AM) {
+    bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    ProfileSummaryInfo &PSI = AM.getResult<ProfileSummaryAnalysis>(M);
+
+    // Run optimizations on each function in the module
+    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter)
+        if (runOnFunction(*Fiter, IDIOM, FAM, PSI)) {
+            transformed = true;
         }
-    }
 
-    if (LocalOptsVerbose) {
-        outs() << "---------------------\n\n";
-    }
+    if (transformed)
+        // If any function was modified, invalidate all analyses
+        return PreservedAnalyses::none();
 
-    return Transformed;
+    // If no changes were made, all analyses are preserved
+    return PreservedAnalyses::all();
 }
 
 /**
- * Applies algebraic identity optimizations to a module.
+ * Folds the comparisons and the selects of a module.
  *
- * This pass implements algebraic simplification rules to optimize code,
- * such as x+0=x, x*1=x, etc.
+ * This pass folds comparisons against constants, such as (x + 5) < 10 = x < 5,
+ * and selects with a known result, see compareFolding().
  *
  * @param M The LLVM Module to optimize
  * @param AM The module analysis manager providing analysis results
  * @return PreservedAnalyses indicating which analyses are preserved after optimization
  */
-PreservedAnalyses AlgebraicIdentity::run(Module &M, ModuleAnalysisManager &AM) {
+PreservedAnalyses CompareFold::run(Module &M, ModuleAnalysisManager &AM) {
     bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    ProfileSummaryInfo &PSI = AM.getResult<ProfileSummaryAnalysis>(M);
 
     // Run optimizations on each function in the module
     for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter)
-        if (runOnFunction(*Fiter, ALGEBRAIC)) {
+        if (runOnFunction(*Fiter, COMPARE, FAM, PSI)) {
             transformed = true;
         }
 
@@ -675,10 +2397,12 @@ PreservedAnalyses AlgebraicIdentity::run(Module &M, ModuleAnalysisManager &AM) {
  */
 PreservedAnalyses StrengthReduction::run(Module &M, ModuleAnalysisManager &AM) {
     bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    ProfileSummaryInfo &PSI = AM.getResult<ProfileSummaryAnalysis>(M);
 
     // Run optimizations on each function in the module
     for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter)
-        if (runOnFunction(*Fiter, STRENGTH)) {
+        if (runOnFunction(*Fiter, STRENGTH, FAM, PSI)) {
             transformed = true;
         }
 
@@ -702,12 +2426,90 @@ PreservedAnalyses StrengthReduction::run(Module &M, ModuleAnalysisManager &AM) {
  */
 PreservedAnalyses MultiInstructionOpt::run(Module &M, ModuleAnalysisManager &AM) {
     bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    ProfileSummaryInfo &PSI = AM.getResult<ProfileSummaryAnalysis>(M);
 
     // Run optimizations on each function in the module
     for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter)
-        if (runOnFunction(*Fiter, MULTI)) {
+        if (runOnFunction(*Fiter, MULTI, FAM, PSI)) {
+            transformed = true;
+        }
+
+    if (transformed)
+        // If any function was modified, invalidate all analyses
+        return PreservedAnalyses::none();
+
+    // If no changes were made, all analyses are preserved
+    return PreservedAnalyses::all();
+}
+
+/**
+ * Applies common subexpression elimination to a module.
+ *
+ * This pass removes the instructions computing the same value as an identical
+ * instruction dominating them, such as the repeated shift sequences created by
+ * the strength reduction.
+ *
+ * @param M The LLVM Module to optimize
+ * @param AM The module analysis manager providing analysis results
+ * @return PreservedAnalyses indicating which analyses are preserved after optimization
+ */
+PreservedAnalyses LocalCSE::run(Module &M, ModuleAnalysisManager &AM) {
+    bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    // Run optimizations on each function in the module
+    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
+        if (Fiter->isDeclaration()) continue;
+
+        if (eliminateCommonSubexpressions(
+            *Fiter,
+            FAM.getResult<DominatorTreeAnalysis>(*Fiter),
+            FAM.getResult<OptimizationRemarkEmitterAnalysis>(*Fiter)
+        )) {
+            transformed = true;
+        }
+    }
+
+    if (!transformed)
+        // If no changes were made, all analyses are preserved
+        return PreservedAnalyses::all();
+
+    // Only instructions are removed, the control flow is untouched. The function
+    // analyses are only kept by a module pass if their proxy is preserved as well
+    PreservedAnalyses PA;
+    PA.preserve<FunctionAnalysisManagerModuleProxy>();
+    PA.preserveSet<CFGAnalyses>();
+    return PA;
+}
+
+/**
+ * Applies the strength reduction of induction variables to a module.
+ *
+ * This pass replaces the multiplications of induction variables by loop invariant
+ * values with additive recurrences, removing them from the loop bodies.
+ *
+ * @param M The LLVM Module to optimize
+ * @param AM The module analysis manager providing analysis results
+ * @return PreservedAnalyses indicating which analyses are preserved after optimization
+ */
+PreservedAnalyses IVStrengthReduction::run(Module &M, ModuleAnalysisManager &AM) {
+    bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    // Run optimizations on each function in the module
+    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
+        if (Fiter->isDeclaration()) continue;
+
+        if (reduceInductionMultiplications(
+            *Fiter,
+            FAM.getResult<LoopAnalysis>(*Fiter),
+            FAM.getResult<ScalarEvolutionAnalysis>(*Fiter),
+            FAM.getResult<OptimizationRemarkEmitterAnalysis>(*Fiter)
+        )) {
             transformed = true;
         }
+    }
 
     if (transformed)
         // If any function was modified, invalidate all analyses
@@ -723,8 +2525,11 @@ PreservedAnalyses MultiInstructionOpt::run(Module &M, ModuleAnalysisManager &AM)
  * This method is called by the LLVM pass manager for each module being processed.
  * It orchestrates the optimization process by:
  * 1. Iterating through each function in the module
- * 2. Running all available optimizations on each function
- * 3. Tracking whether any changes were made to determine which analyses to preserve
+ * 2. Recognizing the bit manipulation idioms, before the other optimizations
+ *    (e.g. the strength reduction of their multiplications) can break them
+ * 3. Running all available optimizations on each function
+ * 4. Removing the redundant instructions left by the optimizations (see eliminateCommonSubexpressions())
+ * 5. Tracking whether any changes were made to determine which analyses to preserve
  *
  * Following LLVM's pass manager requirements, it returns information about which
  * analysis results remain valid after the transformations.
@@ -735,12 +2540,31 @@ PreservedAnalyses MultiInstructionOpt::run(Module &M, ModuleAnalysisManager &AM)
  */
 PreservedAnalyses LocalOpts::run(Module &M, ModuleAnalysisManager &AM) {
     bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    ProfileSummaryInfo &PSI = AM.getResult<ProfileSummaryAnalysis>(M);
 
     // Run optimizations on each function in the module
-    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter)
-        if (runOnFunction(*Fiter, ALL)) {
+    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
+        if (runOnFunction(*Fiter, IDIOM, FAM, PSI)) {
+            transformed = true;
+        }
+
+        if (runOnFunction(*Fiter, ALL, FAM, PSI)) {
+            transformed = true;
+        }
+
+        // The optimizations do not change the control flow, so the dominator tree is still valid
+        if (
+            !Fiter->isDeclaration() &&
+            eliminateCommonSubexpressions(
+                *Fiter,
+                FAM.getResult<DominatorTreeAnalysis>(*Fiter),
+                FAM.getResult<OptimizationRemarkEmitterAnalysis>(*Fiter)
+            )
+        ) {
             transformed = true;
         }
+    }
 
     if (transformed)
         // If any function was modified, invalidate all analyses
@@ -758,8 +2582,12 @@ PreservedAnalyses LocalOpts::run(Module &M, ModuleAnalysisManager &AM) {
  * using options like:
  * - `-passes=local-opts` for all optimizations
  * - `-passes=algebraic-identity` for algebraic simplifications only
+ * - `-passes=idiom-recognition` for the recognition of bit manipulation idioms only
+ * - `-passes=compare-fold` for the folding of comparisons and selects only
  * - `-passes=strength-reduction` for strength reduction only
  * - `-passes=multi-instruction` for multi-instruction optimizations only
+ * - `-passes=local-cse` for common subexpression elimination only
+ * - `-passes=iv-strength-reduction` for the strength reduction of induction variables
  *
  * @return PassPluginLibraryInfo struct with complete plugin registration details
  */
@@ -779,6 +2607,14 @@ PassPluginLibraryInfo getLocalOptsPluginInfo() {
                         MPM.addPass(AlgebraicIdentity());
                         return true;
                     }
+                    if (Name == "idiom-recognition") {
+                        MPM.addPass(IdiomRecognition());
+                        return true;
+                    }
+                    if (Name == "compare-fold") {
+                        MPM.addPass(CompareFold());
+                        return true;
+                    }
                     if (Name == "strength-reduction") {
                         MPM.addPass(StrengthReduction());
                         return true;
@@ -787,6 +2623,14 @@ PassPluginLibraryInfo getLocalOptsPluginInfo() {
                         MPM.addPass(MultiInstructionOpt());
                         return true;
                     }
+                    if (Name == "local-cse") {
+                        MPM.addPass(LocalCSE());
+                        return true;
+                    }
+                    if (Name == "iv-strength-reduction") {
+                        MPM.addPass(IVStrengthReduction());
+                        return true;
+                    }
 
                     return false;
                 });
@@ -7,16 +7,41 @@
 #include "llvm/IR/Value.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/PatternMatch.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/ScopedHashTable.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+#include "llvm/Transforms/Utils/SizeOpts.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Support/KnownBits.h"
+#include "llvm/Support/Debug.h"
+
+#include "AlgebraicIdentityRules.hpp"
+#include "ConstantDivision.hpp"
+#include "ConstantMultiplication.hpp"
+#include "FloatingPointRules.hpp"
 
 #include <cmath>
 #include <map>
 #include <string>
 #include <algorithm>
 #include <queue>
+#include <vector>
 
 namespace llvm {
     class LocalOpts : public PassInfoMixin<LocalOpts> {
@@ -27,6 +52,14 @@ namespace llvm {
             public:
                 PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
     };
+    class IdiomRecognition : public PassInfoMixin<IdiomRecognition> {
+        public:
+            PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+    };
+    class CompareFold : public PassInfoMixin<CompareFold> {
+        public:
+            PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+    };
     class StrengthReduction : public PassInfoMixin<StrengthReduction> {
         public:
             PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
@@ -35,6 +68,14 @@ namespace llvm {
         public:
             PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
     };
+    class LocalCSE : public PassInfoMixin<LocalCSE> {
+        public:
+            PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+    };
+    class IVStrengthReduction : public PassInfoMixin<IVStrengthReduction> {
+        public:
+            PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+    };
 } // namespace llvm
 
 #endif // LLVM_TRANSFORMS_TESTPASS _H
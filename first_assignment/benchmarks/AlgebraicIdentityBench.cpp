@@ -0,0 +1,213 @@
+/**
+ * @file AlgebraicIdentityBench.cpp
+ * @brief Microbenchmark for the algebraic identity matcher
+ *
+ * Compares the table-driven matcher (findAlgebraicIdentity) against the
+ * previous implementation, which ran up to three PatternMatch attempts per
+ * instruction and looked the opcode up in std::vectors.
+ *
+ * A synthetic function with a configurable number of binary operations is
+ * generated, mixing identity candidates (0, 1 and -1 constants, repeated
+ * operands) with ordinary operations. Operands are picked among the last
+ * few values, as in real code. Both matchers only decide whether an identity
+ * applies: they neither create the simplified value nor modify the IR, so
+ * every round works on the same instructions.
+ *
+ * Usage: algebraic-identity-bench [instructions] [rounds]
+ */
+
+#include "../AlgebraicIdentityRules.hpp"
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PatternMatch.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+/**
+ * Matching logic of the previous algebraicIdentityOptimization implementation,
+ * without the verbose output, the creation of the simplified value and the
+ * replacement of the instruction.
+ */
+bool legacyAlgebraicIdentity(Instruction &inst) {
+    Value *LHS = nullptr;
+    Value *RHS = nullptr;
+    ConstantInt *C = nullptr;
+
+    if (
+        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(LHS), PatternMatch::m_ConstantInt(C))) ||
+        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_ConstantInt(C), PatternMatch::m_Value(LHS))) ||
+        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(LHS), PatternMatch::m_Value(RHS)))
+    ) {
+        unsigned int opCode = inst.getOpcode();
+
+        int64_t constantValue = 0;
+        if (C) constantValue = C->getSExtValue();
+
+        std::string identity = "";
+
+        static const std::vector<int> zeroConstantOps = {
+            Instruction::Add,
+            Instruction::Sub,
+            Instruction::Shl,
+            Instruction::LShr,
+            Instruction::And,
+            Instruction::Xor,
+            Instruction::Or,
+        };
+
+        static const std::vector<int> oneConstantOps = {
+            Instruction::Mul,
+            Instruction::UDiv,
+            Instruction::SDiv,
+        };
+
+        if (
+            (C && constantValue == 0 && opCode == Instruction::Mul) ||
+            ((LHS == RHS) && (opCode == Instruction::Sub || opCode == Instruction::Xor))
+        ) {
+            return true;
+        } else if (
+            !(C && opCode == Instruction::Sub && C == inst.getOperand(0)) &&
+            ((C && (constantValue == 0 || constantValue == -1) && std::find(zeroConstantOps.begin(), zeroConstantOps.end(), opCode) != zeroConstantOps.end()) ||
+            (C && constantValue == 1 && std::find(oneConstantOps.begin(), oneConstantOps.end(), opCode) != oneConstantOps.end()) ||
+            ((LHS == RHS) && (opCode == Instruction::And || opCode == Instruction::Or)))
+        ) {
+            return true;
+        } else if ((LHS == RHS) && (opCode == Instruction::SDiv || opCode == Instruction::UDiv)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Builds a function containing nInsts random binary operations on i32 values
+ */
+Function *buildBenchFunction(Module &M, unsigned nInsts) {
+    LLVMContext &ctx = M.getContext();
+    Type *i32 = Type::getInt32Ty(ctx);
+
+    FunctionType *FT = FunctionType::get(i32, {i32, i32}, false);
+    Function *F = Function::Create(FT, Function::ExternalLinkage, "bench", M);
+    BasicBlock *BB = BasicBlock::Create(ctx, "entry", F);
+    IRBuilder<> builder(BB);
+
+    static const Instruction::BinaryOps opCodes[] = {
+        Instruction::Add, Instruction::Sub, Instruction::Mul, Instruction::UDiv,
+        Instruction::SDiv, Instruction::Shl, Instruction::LShr, Instruction::AShr,
+        Instruction::And, Instruction::Or, Instruction::Xor, Instruction::URem
+    };
+    static const int constants[] = {0, 1, -1, 3, 7, 42};
+
+    std::mt19937 rng(42);
+    std::vector<Value*> values = {F->getArg(0), F->getArg(1)};
+
+    auto pickValue = [&]() {
+        return values[values.size() - 1 - rng() % std::min<size_t>(values.size(), 16)];
+    };
+
+    // The builder is not allowed to fold the operations, otherwise the identities would disappear
+    for (unsigned i = 0; i < nInsts; i++) {
+        Instruction::BinaryOps opCode = opCodes[rng() % std::size(opCodes)];
+        Value *LHS = pickValue();
+        Value *RHS = nullptr;
+
+        switch (rng() % 3) {
+            case 0:
+                RHS = ConstantInt::get(i32, constants[rng() % std::size(constants)], true);
+            break;
+
+            case 1:
+                RHS = LHS;
+            break;
+
+            default:
+                RHS = pickValue();
+            break;
+        }
+
+        if (rng() % 4 == 0) std::swap(LHS, RHS);
+
+        Instruction *inst = BinaryOperator::Create(opCode, LHS, RHS);
+        builder.Insert(inst);
+        values.push_back(inst);
+    }
+
+    builder.CreateRet(values.back());
+
+    return F;
+}
+
+template <typename Matcher>
+double timeMatcher(Function &F, unsigned rounds, Matcher matcher, unsigned &matches) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned r = 0; r < rounds; r++) {
+        matches = 0;
+
+        for (Instruction &inst : F.getEntryBlock()) {
+            if (matcher(inst)) matches++;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+int main(int argc, char **argv) {
+    unsigned nInsts = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    LLVMContext ctx;
+    Module M("algebraic-identity-bench", ctx);
+    Function *F = buildBenchFunction(M, nInsts);
+
+    unsigned baselineMatches = 0;
+    unsigned legacyMatches = 0;
+    unsigned tableMatches = 0;
+
+    // Cost of walking the instructions, subtracted from the matchers' times
+    double baselineTime = timeMatcher(*F, rounds, [](Instruction &inst) {
+        return inst.getOpcode() == Instruction::Ret;
+    }, baselineMatches);
+
+    double legacyTime = timeMatcher(*F, rounds, [](Instruction &inst) {
+        return legacyAlgebraicIdentity(inst);
+    }, legacyMatches);
+
+    double tableTime = timeMatcher(*F, rounds, [](Instruction &inst) {
+        BinaryOperator *BO = dyn_cast<BinaryOperator>(&inst);
+        Value *variable = nullptr;
+
+        return BO && findAlgebraicIdentity(*BO, variable) != nullptr;
+    }, tableMatches);
+
+    double totalInsts = static_cast<double>(F->getEntryBlock().size()) * rounds;
+
+    outs() << "Instructions: " << F->getEntryBlock().size() << ", rounds: " << rounds << "\n\n";
+    legacyTime -= baselineTime;
+    tableTime -= baselineTime;
+
+    outs() << "Instruction walk: " << format("%.2f", baselineTime / totalInsts) << " ns/inst (subtracted)\n";
+    outs() << "Legacy matcher:   " << format("%.2f", legacyTime / totalInsts) << " ns/inst, "
+        << legacyMatches << " matches\n";
+    outs() << "Table matcher:    " << format("%.2f", tableTime / totalInsts) << " ns/inst, "
+        << tableMatches << " matches\n";
+    outs() << "Speedup: " << format("%.2f", legacyTime / tableTime) << "x\n";
+
+    // The match counts differ because the previous implementation also matched
+    // wrong identities (e.g. x + -1 = x, 1 / x = x) that the rule table does not contain
+    return 0;
+}
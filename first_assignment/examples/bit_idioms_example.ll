@@ -0,0 +1,121 @@
+; Bit manipulation idioms written by hand, recognized by -passes=idiom-recognition
+; (and by local-opts) and replaced with the intrinsics the backend lowers to a
+; single instruction (rol, popcnt, lzcnt, bswap on x86). Each function lists the
+; expected result.
+;
+; C++ representation:
+;
+; uint32_t rotate_left(uint32_t x) {
+;   return (x << 5) | (x >> 27);              // fshl(x, x, 5)
+; }
+;
+; uint64_t rotate_masked(uint64_t x, uint64_t r) {
+;   return (x << (r & 63)) | (x >> (-r & 63)); // fshl(x, x, r), defined for r = 0
+; }
+;
+; uint32_t popcount(uint32_t i) {
+;   i = i - ((i >> 1) & 0x55555555);
+;   i = (i & 0x33333333) + ((i >> 2) & 0x33333333);
+;   i = (i + (i >> 4)) & 0x0F0F0F0F;
+;   return (i * 0x01010101) >> 24;            // ctpop(i)
+; }
+;
+; unsigned _BitInt(256) popcount_wide(unsigned _BitInt(256) i) {
+;   ...                                       // same sequence with 32 byte masks
+;   return (i * 0x0101...01) >> 248;          // not ctpop(i): the count 256 gives 0
+; }
+;
+; uint32_t leading_zeros(uint32_t x) {
+;   x |= x >> 1; x |= x >> 2; x |= x >> 4; x |= x >> 8; x |= x >> 16;
+;   return __builtin_popcount(~x);            // ctlz(x), 32 for x = 0
+; }
+;
+; uint32_t byte_swap(uint32_t x) {
+;   return (x << 24) | ((x << 8) & 0xFF0000) | ((x >> 8) & 0xFF00) | (x >> 24);  // bswap(x)
+; }
+
+define dso_local i32 @rotate_left(i32 %x) {
+  ; Expected: %1 = call i32 @llvm.fshl.i32(i32 %x, i32 %x, i32 5)
+  %shl = shl i32 %x, 5
+  %shr = lshr i32 %x, 27
+  %result = or i32 %shl, %shr
+  ret i32 %result
+}
+
+define dso_local i64 @rotate_masked(i64 %x, i64 %r) {
+  ; Expected: %1 = call i64 @llvm.fshl.i64(i64 %x, i64 %x, i64 %r)
+  %left = and i64 %r, 63
+  %neg = sub i64 0, %r
+  %right = and i64 %neg, 63
+  %shl = shl i64 %x, %left
+  %shr = lshr i64 %x, %right
+  %result = or i64 %shl, %shr
+  ret i64 %result
+}
+
+define dso_local i32 @popcount(i32 %i) {
+  ; Expected: %1 = call i32 @llvm.ctpop.i32(i32 %i)
+  %1 = lshr i32 %i, 1
+  %2 = and i32 %1, 1431655765
+  %3 = sub i32 %i, %2
+  %4 = and i32 %3, 858993459
+  %5 = lshr i32 %3, 2
+  %6 = and i32 %5, 858993459
+  %7 = add i32 %4, %6
+  %8 = lshr i32 %7, 4
+  %9 = add i32 %7, %8
+  %10 = and i32 %9, 252645135
+  %11 = mul i32 %10, 16843009
+  %result = lshr i32 %11, 24
+  ret i32 %result
+}
+
+define dso_local i256 @popcount_wide(i256 %i) {
+  ; Expected: unchanged, the count of an i256 does not fit in the top byte
+  %1 = lshr i256 %i, 1
+  %2 = and i256 %1, 38597363079105398474523661669562635951089994888546854679819194669304376546645
+  %3 = sub i256 %i, %2
+  %4 = and i256 %3, 23158417847463239084714197001737581570653996933128112807891516801582625927987
+  %5 = lshr i256 %3, 2
+  %6 = and i256 %5, 23158417847463239084714197001737581570653996933128112807891516801582625927987
+  %7 = add i256 %4, %6
+  %8 = lshr i256 %7, 4
+  %9 = add i256 %7, %8
+  %10 = and i256 %9, 6811299366900952671974763824040465167839410862684739061144563765171360567055
+  %11 = mul i256 %10, 454086624460063511464984254936031011189294057512315937409637584344757371137
+  %result = lshr i256 %11, 248
+  ret i256 %result
+}
+
+define dso_local i32 @leading_zeros(i32 %x) {
+  ; Expected: %1 = call i32 @llvm.ctlz.i32(i32 %x, i1 false)
+  %1 = lshr i32 %x, 1
+  %2 = or i32 %x, %1
+  %3 = lshr i32 %2, 2
+  %4 = or i32 %2, %3
+  %5 = lshr i32 %4, 4
+  %6 = or i32 %4, %5
+  %7 = lshr i32 %6, 8
+  %8 = or i32 %6, %7
+  %9 = lshr i32 %8, 16
+  %10 = or i32 %8, %9
+  %not = xor i32 %10, -1
+  %result = call i32 @llvm.ctpop.i32(i32 %not)
+  ret i32 %result
+}
+
+define dso_local i32 @byte_swap(i32 %x) {
+  ; Expected: %rev3 = call i32 @llvm.bswap.i32(i32 %x)
+  %1 = shl i32 %x, 24
+  %2 = shl i32 %x, 8
+  %3 = and i32 %2, 16711680
+  %4 = or i32 %1, %3
+  %5 = lshr i32 %x, 8
+  %6 = and i32 %5, 65280
+  %7 = or i32 %4, %6
+  %8 = lshr i32 %x, 24
+  %result = or i32 %7, %8
+  ret i32 %result
+}
+
+declare i32 @llvm.ctpop.i32(i32)
@@ -0,0 +1,105 @@
+; Regression corpus for the integer widths other than i32.
+;
+; Every constant is handled as an APInt of the width of its operation, so the
+; same rules apply to narrow (i8, i16), odd (i33) and wide (i128) integers, and
+; to vectors of them. Each function lists the result expected from
+; -passes=local-opts.
+;
+; C++ representation (i128 is __int128):
+;
+; uint8_t narrow_mul(uint8_t x) {
+;   return x * 10;                // (x << 2) + x, then << 1
+; }
+;
+; int8_t narrow_identities(int8_t x) {
+;   int8_t a = x & -1;            // Algebraic identity: x & 0xff = x
+;   int8_t b = a | 0;             // Algebraic identity: x | 0 = x
+;   return b * -1;                // Strength reduction: 0 - x
+; }
+;
+; int16_t short_division(int16_t x) {
+;   return x / 7;                 // Signed magic number with a 32 bit multiply-high
+; }
+;
+; uint16_t short_remainder(uint16_t x) {
+;   return x % 1024;              // x & 1023
+; }
+;
+; __int128 wide_shift(__int128 x) {
+;   return x * ((__int128)1 << 100);  // x << 100, a shift amount beyond 64 bits
+; }
+;
+; unsigned __int128 wide_division(unsigned __int128 x) {
+;   return x / 3;                 // Unsigned magic number with a 256 bit multiply-high
+; }
+;
+; __int128 wide_chain(__int128 x) {
+;   __int128 a = x + ((__int128)1 << 80);
+;   return a - ((__int128)1 << 80) + 5;   // Constants folded: x + 5
+; }
+;
+; i33 is not a C++ type: it shows that no width is special cased
+
+define dso_local zeroext i8 @narrow_mul(i8 zeroext %x) {
+  ; Expected: %1 = shl i8 %x, 2 ; %2 = add i8 %1, %x ; %3 = shl i8 %2, 1
+  %result = mul i8 %x, 10
+  ret i8 %result
+}
+
+define dso_local signext i8 @narrow_identities(i8 signext %x) {
+  ; Expected: %neg = sub i8 0, %x
+  %a = and i8 %x, -1
+  %b = or i8 %a, 0
+  %result = mul i8 %b, -1
+  ret i8 %result
+}
+
+define dso_local signext i16 @short_division(i16 signext %x) {
+  ; Expected: sext to i32, mul by the magic number 18725, lshr 16, trunc,
+  ; ashr 1, plus the sign bit of the quotient
+  %result = sdiv i16 %x, 7
+  ret i16 %result
+}
+
+define dso_local zeroext i16 @short_remainder(i16 zeroext %x) {
+  ; Expected: %1 = and i16 %x, 1023
+  %result = urem i16 %x, 1024
+  ret i16 %result
+}
+
+define dso_local i128 @wide_shift(i128 %x) {
+  ; Expected: %1 = shl i128 %x, 100
+  %result = mul i128 %x, 1267650600228229401496703205376
+  ret i128 %result
+}
+
+define dso_local i128 @wide_division(i128 %x) {
+  ; Expected: zext to i256, mul by 0xAAAA...AAAB, lshr 128, trunc, lshr 1
+  %result = udiv i128 %x, 3
+  ret i128 %result
+}
+
+define dso_local i128 @wide_chain(i128 %x) {
+  ; Expected: %1 = add i128 %x, 5
+  %a = add i128 %x, 1208925819614629174706176
+  %b = sub i128 %a, 1208925819614629174706176
+  %result = add i128 %b, 5
+  ret i128 %result
+}
+
+define dso_local i33 @odd_width(i33 %x) {
+  ; Expected: %1 = shl i33 %x, 32 (x * 2^32 is the sign bit of an i33)
+  ; and %2 = lshr i33 %x, 4 (x / 16)
+  %a = mul i33 %x, 4294967296
+  %b = udiv i33 %x, 16
+  %result = add i33 %a, %b
+  ret i33 %result
+}
+
+define dso_local <4 x i16> @vector_width(<4 x i16> %x) {
+  ; Expected: %1 = shl <4 x i16> %x, <i16 3, ...> and %2 = lshr <4 x i16> %x, <i16 1, i16 2, i16 3, i16 4>
+  %a = mul <4 x i16> %x, <i16 8, i16 8, i16 8, i16 8>
+  %b = udiv <4 x i16> %x, <i16 2, i16 4, i16 8, i16 16>
+  %result = add <4 x i16> %a, %b
+  ret <4 x i16> %result
+}
@@ -0,0 +1,232 @@
+#ifndef LLVM_TRANSFORMS_BITVECTORKERNELS_H
+#define LLVM_TRANSFORMS_BITVECTORKERNELS_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define DATAFLOW_KERNELS_AVX2 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DATAFLOW_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace llvm {
+    enum class MeetOperator { Intersection, Union };
+
+    /**
+        Kernels of the bit-vector dataflow problems, working on the words of the
+        vectors: the meet of the outputs of N neighbours, fused with the transfer
+        function OUT = GEN | (IN & ~KILL) and with the detection of a change of the
+        output, in a single pass over memory. Every word of the inputs is loaded
+        once, and the meet never goes through a temporary vector.
+
+        The words are processed 256 bits at a time with AVX2 (selected at run time,
+        on the x86 processors that support it) or 128 bits at a time with NEON
+        (always available on AArch64), and one word at a time otherwise
+    */
+    namespace bitvector_kernels {
+        // BitVector::BitWord is private, but the words are exposed by getData()
+        using BitWord = decltype(std::declval<const BitVector&>().getData())::value_type;
+
+        template <MeetOperator Meet>
+        inline BitWord meetWord(BitWord a, BitWord b) {
+            return Meet == MeetOperator::Intersection ? a & b : a | b;
+        }
+
+        /**
+            Portable version, also used for the words after the last full vector.
+
+            Returns true if a word of out changed
+        */
+        template <MeetOperator Meet>
+        inline bool meetTransferScalar(
+            const BitWord *const *inputs, unsigned numInputs, const BitWord *gen, const BitWord *kill,
+            BitWord *out, size_t begin, size_t end
+        ) {
+            BitWord changed = 0;
+
+            for (size_t i = begin; i < end; i++) {
+                BitWord acc = inputs[0][i];
+
+                for (unsigned k = 1; k < numInputs; k++) {
+                    acc = meetWord<Meet>(acc, inputs[k][i]);
+                }
+
+                if (kill) acc &= ~kill[i];
+                if (gen) acc |= gen[i];
+
+                changed |= acc ^ out[i];
+                out[i] = acc;
+            }
+
+            return changed != 0;
+        }
+
+#if defined(DATAFLOW_KERNELS_AVX2)
+        template <MeetOperator Meet>
+        __attribute__((target("avx2"))) inline __m256i meetAVX2(__m256i a, __m256i b) {
+            return Meet == MeetOperator::Intersection ? _mm256_and_si256(a, b) : _mm256_or_si256(a, b);
+        }
+
+        template <MeetOperator Meet>
+        __attribute__((target("avx2"))) inline bool meetTransferAVX2(
+            const BitWord *const *inputs, unsigned numInputs, const BitWord *gen, const BitWord *kill,
+            BitWord *out, size_t numWords
+        ) {
+            constexpr size_t step = sizeof(__m256i) / sizeof(BitWord);
+            __m256i changed = _mm256_setzero_si256();
+            size_t i = 0;
+
+            for (; i + step <= numWords; i += step) {
+                __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputs[0] + i));
+
+                for (unsigned k = 1; k < numInputs; k++) {
+                    acc = meetAVX2<Meet>(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputs[k] + i)));
+                }
+
+                // andnot computes ~first & second
+                if (kill) acc = _mm256_andnot_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(kill + i)), acc);
+                if (gen) acc = _mm256_or_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gen + i)));
+
+                __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out + i));
+                changed = _mm256_or_si256(changed, _mm256_xor_si256(acc, previous));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), acc);
+            }
+
+            bool vectorChanged = !_mm256_testz_si256(changed, changed);
+            bool tailChanged = meetTransferScalar<Meet>(inputs, numInputs, gen, kill, out, i, numWords);
+
+            return vectorChanged || tailChanged;
+        }
+
+        inline bool hasAVX2() {
+            static const bool supported = __builtin_cpu_supports("avx2");
+
+            return supported;
+        }
+#elif defined(DATAFLOW_KERNELS_NEON)
+        template <MeetOperator Meet>
+        inline uint8x16_t meetNEON(uint8x16_t a, uint8x16_t b) {
+            return Meet == MeetOperator::Intersection ? vandq_u8(a, b) : vorrq_u8(a, b);
+        }
+
+        template <MeetOperator Meet>
+        inline bool meetTransferNEON(
+            const BitWord *const *inputs, unsigned numInputs, const BitWord *gen, const BitWord *kill,
+            BitWord *out, size_t numWords
+        ) {
+            constexpr size_t step = sizeof(uint8x16_t) / sizeof(BitWord);
+            uint8x16_t changed = vdupq_n_u8(0);
+            size_t i = 0;
+
+            for (; i + step <= numWords; i += step) {
+                uint8x16_t acc = vld1q_u8(reinterpret_cast<const uint8_t*>(inputs[0] + i));
+
+                for (unsigned k = 1; k < numInputs; k++) {
+                    acc = meetNEON<Meet>(acc, vld1q_u8(reinterpret_cast<const uint8_t*>(inputs[k] + i)));
+                }
+
+                // bic computes first & ~second
+                if (kill) acc = vbicq_u8(acc, vld1q_u8(reinterpret_cast<const uint8_t*>(kill + i)));
+                if (gen) acc = vorrq_u8(acc, vld1q_u8(reinterpret_cast<const uint8_t*>(gen + i)));
+
+                uint8x16_t previous = vld1q_u8(reinterpret_cast<const uint8_t*>(out + i));
+                changed = vorrq_u8(changed, veorq_u8(acc, previous));
+                vst1q_u8(reinterpret_cast<uint8_t*>(out + i), acc);
+            }
+
+            uint64x2_t lanes = vreinterpretq_u64_u8(changed);
+            bool vectorChanged = (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) != 0;
+            bool tailChanged = meetTransferScalar<Meet>(inputs, numInputs, gen, kill, out, i, numWords);
+
+            return vectorChanged || tailChanged;
+        }
+#endif
+
+        /**
+            Computes out = gen | (meet(inputs) & ~kill) on numWords words, with the
+            fastest kernel the processor supports. gen and kill may be nullptr (empty).
+
+            Returns true if a word of out changed
+        */
+        template <MeetOperator Meet>
+        inline bool meetTransferWords(
+            const BitWord *const *inputs, unsigned numInputs, const BitWord *gen, const BitWord *kill,
+            BitWord *out, size_t numWords
+        ) {
+#if defined(DATAFLOW_KERNELS_AVX2)
+            if (hasAVX2()) return meetTransferAVX2<Meet>(inputs, numInputs, gen, kill, out, numWords);
+#elif defined(DATAFLOW_KERNELS_NEON)
+            return meetTransferNEON<Meet>(inputs, numInputs, gen, kill, out, numWords);
+#endif
+            return meetTransferScalar<Meet>(inputs, numInputs, gen, kill, out, 0, numWords);
+        }
+    } // namespace bitvector_kernels
+
+    /**
+        Sets out to gen | (meet(inputs) & ~kill), in a single pass over the words of the
+        vectors. All the vectors must have the size of out, and gen and kill may be
+        nullptr (empty). At most 16 inputs are met in one pass, the next ones with
+        further passes over out.
+
+        Returns true if out changed
+    */
+    template <MeetOperator Meet>
+    bool meetAndTransfer(ArrayRef<const BitVector*> inputs, const BitVector *gen, const BitVector *kill, BitVector &out) {
+        using namespace bitvector_kernels;
+
+        assert(!inputs.empty() && "the meet needs at least one input");
+
+        if (out.empty()) return false;
+
+        size_t numWords = out.getData().size();
+        const BitWord *words[16];
+        unsigned numInputs = std::min<size_t>(inputs.size(), 16);
+
+        for (unsigned k = 0; k < numInputs; k++) {
+            assert(inputs[k]->size() == out.size() && "the inputs must have the size of the output");
+            words[k] = inputs[k]->getData().data();
+        }
+
+        // BitVector only exposes its words as const, but out is not: the bits past its
+        // size stay zero, since they are zero in all the inputs and in gen
+        BitWord *outWords = const_cast<BitWord*>(out.getData().data());
+        const BitWord *genWords = gen ? gen->getData().data() : nullptr;
+        const BitWord *killWords = kill ? kill->getData().data() : nullptr;
+
+        if (numInputs == inputs.size()) {
+            return meetTransferWords<Meet>(words, numInputs, genWords, killWords, outWords, numWords);
+        }
+
+        // Met with the first inputs, out becomes one of the inputs of the next pass
+        BitVector partial(out.size());
+        BitWord *partialWords = const_cast<BitWord*>(partial.getData().data());
+        meetTransferWords<Meet>(words, numInputs, nullptr, nullptr, partialWords, numWords);
+
+        for (size_t next = numInputs; next < inputs.size();) {
+            unsigned count = 1;
+            words[0] = partialWords;
+
+            while (count < 16 && next < inputs.size()) {
+                words[count++] = inputs[next++]->getData().data();
+            }
+
+            bool last = next == inputs.size();
+
+            if (last) return meetTransferWords<Meet>(words, count, genWords, killWords, outWords, numWords);
+
+            meetTransferWords<Meet>(words, count, nullptr, nullptr, partialWords, numWords);
+        }
+
+        return false;
+    }
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_BITVECTORKERNELS_H
@@ -0,0 +1,148 @@
+/**
+    Microbenchmark of the kernels of bitVectorKernels.hpp against the operators of
+    llvm::BitVector, on the meet of N inputs followed by OUT = GEN | (IN & ~KILL)
+    and the check for a change of the output, i.e. one visit of a block by the
+    dataflow solver.
+
+    It is not part of the passes, build it by hand with:
+
+    g++ -O2 -std=c++17 $(llvm-config --cxxflags) bitVectorKernelsBenchmark.cpp \
+        $(llvm-config --ldflags --libs support) -o bitVectorKernelsBenchmark
+*/
+#include "bitVectorKernels.hpp"
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/Format.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+    BitVector randomVector(unsigned size, std::mt19937_64 &rng, unsigned density) {
+        BitVector result(size);
+
+        for (unsigned i = 0; i < size; i++) {
+            if (rng() % 100 < density) result.set(i);
+        }
+
+        return result;
+    }
+
+    /**
+        The sequence the solver used before the kernels: a temporary input, one pass
+        per operator, and a comparison with the previous output
+    */
+    template <MeetOperator Meet>
+    bool meetAndTransferBitVector(ArrayRef<const BitVector*> inputs, const BitVector *gen, const BitVector *kill, BitVector &out) {
+        BitVector input = *inputs[0];
+
+        for (const BitVector *other : inputs.drop_front()) {
+            if (Meet == MeetOperator::Intersection) input &= *other;
+            else input |= *other;
+        }
+
+        if (kill) input.reset(*kill);
+        if (gen) input |= *gen;
+
+        if (input == out) return false;
+
+        out = std::move(input);
+        return true;
+    }
+
+    template <MeetOperator Meet>
+    bool meetAndTransferScalar(ArrayRef<const BitVector*> inputs, const BitVector *gen, const BitVector *kill, BitVector &out) {
+        using namespace bitvector_kernels;
+
+        SmallVector<const BitWord*, 8> words;
+
+        for (const BitVector *input : inputs) {
+            words.push_back(input->getData().data());
+        }
+
+        return meetTransferScalar<Meet>(
+            words.data(), words.size(), gen->getData().data(), kill->getData().data(),
+            const_cast<BitWord*>(out.getData().data()), 0, out.getData().size()
+        );
+    }
+
+    /**
+        Returns the nanoseconds per call of the kernel
+    */
+    template <typename Kernel>
+    double measure(Kernel kernel, ArrayRef<const BitVector*> inputs, const BitVector &gen, const BitVector &kill, BitVector &out, unsigned size) {
+        // About 2^30 bits processed per measure, at least 16 calls
+        unsigned calls = std::max<unsigned>(16, (1u << 30) / (size * (inputs.size() + 3)));
+        unsigned changes = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (unsigned i = 0; i < calls; i++) {
+            changes += kernel(inputs, &gen, &kill, out);
+        }
+
+        auto end = std::chrono::steady_clock::now();
+
+        // Keeps the calls from being optimized away
+        if (changes > calls) outs() << "";
+
+        return std::chrono::duration<double, std::nano>(end - start).count() / calls;
+    }
+}
+
+int main() {
+    std::mt19937_64 rng(42);
+
+    outs() << "AVX2 kernels: ";
+#if defined(DATAFLOW_KERNELS_AVX2)
+    outs() << (bitvector_kernels::hasAVX2() ? "yes" : "not supported") << "\n";
+#elif defined(DATAFLOW_KERNELS_NEON)
+    outs() << "no, NEON kernels\n";
+#else
+    outs() << "no, scalar fallback\n";
+#endif
+
+    outs() << "\n       bits  inputs   BitVector (ns)    scalar (ns)    kernel (ns)   speedup\n";
+
+    for (unsigned size : {1000u, 10000u, 100000u, 1000000u}) {
+        for (unsigned numInputs : {1u, 2u, 4u, 8u}) {
+            std::vector<BitVector> storage;
+
+            for (unsigned k = 0; k < numInputs; k++) {
+                storage.push_back(randomVector(size, rng, 90));
+            }
+
+            SmallVector<const BitVector*, 8> inputs;
+
+            for (const BitVector &input : storage) {
+                inputs.push_back(&input);
+            }
+
+            BitVector gen = randomVector(size, rng, 5);
+            BitVector kill = randomVector(size, rng, 5);
+
+            BitVector expected(size), scalarOut(size), kernelOut(size);
+            meetAndTransferBitVector<MeetOperator::Intersection>(inputs, &gen, &kill, expected);
+            meetAndTransferScalar<MeetOperator::Intersection>(inputs, &gen, &kill, scalarOut);
+            meetAndTransfer<MeetOperator::Intersection>(inputs, &gen, &kill, kernelOut);
+
+            if (scalarOut != expected || kernelOut != expected) {
+                errs() << "Wrong result with " << size << " bits and " << numInputs << " inputs\n";
+                return 1;
+            }
+
+            double bitVector = measure(meetAndTransferBitVector<MeetOperator::Intersection>, inputs, gen, kill, expected, size);
+            double scalar = measure(meetAndTransferScalar<MeetOperator::Intersection>, inputs, gen, kill, scalarOut, size);
+            double kernel = measure(meetAndTransfer<MeetOperator::Intersection>, inputs, gen, kill, kernelOut, size);
+
+            outs() << format("%11u  %6u  %15.1f  %13.1f  %13.1f  %7.2fx\n", size, numInputs, bitVector, scalar, kernel, bitVector / kernel);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+#ifndef LLVM_TRANSFORMS_DATAFLOWSOLVER_H
+#define LLVM_TRANSFORMS_DATAFLOWSOLVER_H
+
+#include "dataflowWorklist.hpp"
+#include "bitVectorKernels.hpp"
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <type_traits>
+#include <utility>
+
+namespace llvm {
+    /**
+        True for the transfer functions of the bit-vector problems, given as the GEN and
+        KILL sets of every block: getGen(BasicBlock&) and getKill(BasicBlock&) return
+        a BitVector, or nullptr for an empty set
+    */
+    template <typename Transfer, typename = void>
+    struct IsGenKillTransfer : std::false_type {};
+
+    template <typename Transfer>
+    struct IsGenKillTransfer<Transfer, std::void_t<decltype(&Transfer::getGen), decltype(&Transfer::getKill)>> :
+        std::true_type {};
+
+    /**
+        Iterative solver of a dataflow problem over the blocks of a function, with the
+        direction of the problem, its lattice and its transfer function as policies.
+
+        The Lattice policy provides:
+        - Element: the type of the dataflow facts of a block, comparable with ==
+        - Element boundary(BasicBlock &BB): the input of the boundary blocks, the entry
+          block of a forward problem and the exit blocks of a backward one
+        - Element initial(BasicBlock &BB): the input of a block none of whose neighbours
+          has been computed yet, i.e. the top of the lattice (everything for a must
+          problem, nothing for a may problem)
+        - void meet(Element &result, const Element &other): lowers result to the meet
+          of the two elements
+
+        The Transfer policy provides void operator()(BasicBlock &BB, Element &state),
+        which turns the input of a block into its output.
+
+        Bit-vector problems can give their transfer function as GEN and KILL sets instead
+        (see IsGenKillTransfer), with Element = BitVector and the meet as a constant
+        MeetOperator meetOperator of the lattice: the meet of all the neighbours, the
+        transfer function and the comparison with the previous output are then computed
+        together by the kernels of bitVectorKernels.hpp, in a single pass over memory.
+
+        The input of a block is the meet of the outputs of its predecessors (forward) or
+        successors (backward) computed so far: the ones reached through a back edge are
+        skipped on the first visit, as if they were at the top of the lattice. Blocks are
+        visited with a DataflowWorklist, so only the neighbours of a block whose output
+        changed are visited again.
+    */
+    template <DataflowDirection Direction, typename Lattice, typename Transfer>
+    class DataflowSolver {
+        public:
+            using Element = typename Lattice::Element;
+
+            explicit DataflowSolver(Function &F, Lattice lattice = Lattice(), Transfer transfer = Transfer()) :
+                F(F), lattice(std::move(lattice)), transfer(std::move(transfer)), worklist(F, Direction) {}
+
+            /**
+                Solves the problem, calling onRoundEnd with the number of the iteration
+                at the end of every iteration over the loops.
+
+                Returns the number of iterations
+            */
+            unsigned solve(function_ref<void(unsigned)> onRoundEnd = nullptr) {
+                worklist.solve([this](BasicBlock &BB) { return visitBlock(BB); }, onRoundEnd);
+
+                return worklist.getNumRounds();
+            }
+
+            /**
+                Returns the output of a block: the facts at its end for a forward problem,
+                at its beginning for a backward one. nullptr if it was never computed
+            */
+            const Element *getResult(BasicBlock *BB) const {
+                auto it = results.find(BB);
+
+                return it != results.end() ? &it->second : nullptr;
+            }
+
+            unsigned getNumVisits() const {
+                return worklist.getNumVisits();
+            }
+
+            unsigned getNumRounds() const {
+                return worklist.getNumRounds();
+            }
+
+        private:
+            Function &F;
+            Lattice lattice;
+            Transfer transfer;
+
+            DataflowWorklist worklist;
+            DenseMap<BasicBlock*, Element> results;
+
+            bool isBoundary(BasicBlock &BB) const {
+                if (Direction == DataflowDirection::Forward) return &BB == &F.getEntryBlock();
+
+                return succ_empty(&BB);
+            }
+
+            Element computeInput(BasicBlock &BB) {
+                if (isBoundary(BB)) return lattice.boundary(BB);
+
+                const Element *first = nullptr;
+                Element input;
+
+                auto meetWith = [&](BasicBlock *neighbour) {
+                    const Element *result = getResult(neighbour);
+                    if (!result) return;
+
+                    if (!first) {
+                        first = result;
+                        input = *result;
+                    } else {
+                        lattice.meet(input, *result);
+                    }
+                };
+
+                if (Direction == DataflowDirection::Forward) {
+                    for (BasicBlock *pred : predecessors(&BB)) meetWith(pred);
+                } else {
+                    for (BasicBlock *succ : successors(&BB)) meetWith(succ);
+                }
+
+                if (!first) return lattice.initial(BB);
+
+                return input;
+            }
+
+            /**
+                Returns true if the output of the block changed
+            */
+            bool visitBlock(BasicBlock &BB) {
+                if constexpr (IsGenKillTransfer<Transfer>::value) {
+                    return visitGenKillBlock(BB);
+                } else {
+                    Element state = computeInput(BB);
+                    transfer(BB, state);
+
+                    auto it = results.find(&BB);
+
+                    if (it == results.end()) {
+                        results.insert({&BB, std::move(state)});
+                        return true;
+                    }
+
+                    if (it->second == state) return false;
+
+                    it->second = std::move(state);
+                    return true;
+                }
+            }
+
+            bool visitGenKillBlock(BasicBlock &BB) {
+                // The output is inserted first, so that the inputs do not move afterwards
+                auto [it, isFirstVisit] = results.try_emplace(&BB);
+                BitVector &output = it->second;
+
+                SmallVector<const BitVector*, 8> inputs;
+                BitVector initialInput;
+
+                auto addInput = [&](BasicBlock *neighbour) {
+                    // A self loop is skipped on the first visit, like the other back edges
+                    if (neighbour == &BB && isFirstVisit) return;
+
+                    if (const BitVector *result = getResult(neighbour)) inputs.push_back(result);
+                };
+
+                if (isBoundary(BB)) {
+                    initialInput = lattice.boundary(BB);
+                } else {
+                    if (Direction == DataflowDirection::Forward) {
+                        for (BasicBlock *pred : predecessors(&BB)) addInput(pred);
+                    } else {
+                        for (BasicBlock *succ : successors(&BB)) addInput(succ);
+                    }
+
+                    if (inputs.empty()) initialInput = lattice.initial(BB);
+                }
+
+                if (inputs.empty()) inputs.push_back(&initialInput);
+                if (isFirstVisit) output.resize(inputs[0]->size());
+
+                bool changed = meetAndTransfer<Lattice::meetOperator>(inputs, transfer.getGen(BB), transfer.getKill(BB), output);
+
+                return changed || isFirstVisit;
+            }
+    };
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_DATAFLOWSOLVER_H
@@ -0,0 +1,180 @@
+#ifndef LLVM_TRANSFORMS_DATAFLOWWORKLIST_H
+#define LLVM_TRANSFORMS_DATAFLOWWORKLIST_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace llvm {
+    enum class DataflowDirection { Forward, Backward };
+
+    /**
+        Worklist of the basic blocks of a function, shared by the dataflow solvers.
+
+        Blocks are numbered once, in the order that visits a block after the ones its
+        input depends on (except along the back edges of the loops):
+        - forward problems: reverse post-order of the CFG from the entry block
+        - backward problems: reverse post-order of the reverse CFG from the exit blocks,
+          i.e. the successors of a block come before it
+
+        The blocks no DFS reaches (unreachable code, or loops with no exit for backward
+        problems) are numbered too, as the roots of further searches in layout order.
+
+        A block pushed several times before being visited is visited once, and the
+        lowest number is always popped first: when the visit of a block changes its
+        output, only the blocks that depend on it are pushed again, and they are visited
+        in the same order. A round ends when the number popped goes back, i.e. a loop
+        is iterated again.
+    */
+    class DataflowWorklist {
+        public:
+            DataflowWorklist(Function &F, DataflowDirection direction) : direction(direction) {
+                SmallPtrSet<BasicBlock*, 32> visited;
+                std::vector<BasicBlock*> postOrder;
+
+                auto search = [&](BasicBlock *root) {
+                    if (direction == DataflowDirection::Forward) {
+                        for (BasicBlock *BB : post_order_ext(root, visited)) postOrder.push_back(BB);
+                    } else {
+                        for (BasicBlock *BB : inverse_post_order_ext(root, visited)) postOrder.push_back(BB);
+                    }
+                };
+
+                // The entry block, or the exit blocks, are searched first
+                SmallVector<BasicBlock*, 8> roots;
+
+                for (BasicBlock &BB : F) {
+                    roots.push_back(&BB);
+                }
+
+                if (direction == DataflowDirection::Backward) {
+                    std::stable_partition(roots.begin(), roots.end(), [](BasicBlock *BB) { return succ_empty(BB); });
+                }
+
+                for (BasicBlock *root : roots) {
+                    if (!visited.count(root)) search(root);
+                }
+
+                order.assign(postOrder.rbegin(), postOrder.rend());
+
+                for (unsigned i = 0; i < order.size(); i++) {
+                    index[order[i]] = i;
+                }
+
+                queued.resize(order.size());
+            }
+
+            bool empty() const {
+                return queue.empty();
+            }
+
+            void push(BasicBlock *BB) {
+                unsigned i = index.lookup(BB);
+
+                if (queued.test(i)) return;
+
+                queued.set(i);
+                queue.push(i);
+            }
+
+            void pushAll() {
+                for (BasicBlock *BB : order) {
+                    push(BB);
+                }
+            }
+
+            /**
+                Pushes the blocks whose input depends on the output of a block: its
+                successors for forward problems, its predecessors for backward ones
+            */
+            void pushDependents(BasicBlock *BB) {
+                if (direction == DataflowDirection::Forward) {
+                    for (BasicBlock *succ : successors(BB)) push(succ);
+                } else {
+                    for (BasicBlock *pred : predecessors(BB)) push(pred);
+                }
+            }
+
+            BasicBlock *pop() {
+                unsigned i = queue.top();
+                queue.pop();
+                queued.reset(i);
+
+                if (visits == 0 || i <= last) rounds++;
+
+                last = i;
+                visits++;
+
+                return order[i];
+            }
+
+            /**
+                Returns true if the next block popped starts a new round, or if nothing
+                is left to visit
+            */
+            bool isEndOfRound() const {
+                return queue.empty() || queue.top() <= last;
+            }
+
+            /**
+                Pushes every block, then visits them until the worklist is empty.
+                The visit returns true if the output of the block changed, and
+                the blocks that depend on it are pushed again.
+
+                Returns the number of block visits
+            */
+            unsigned solve(function_ref<bool(BasicBlock&)> visit, function_ref<void(unsigned)> onRoundEnd = nullptr) {
+                pushAll();
+
+                while (!empty()) {
+                    BasicBlock *BB = pop();
+
+                    if (visit(*BB)) pushDependents(BB);
+                    if (onRoundEnd && isEndOfRound()) onRoundEnd(rounds);
+                }
+
+                return visits;
+            }
+
+            /**
+                Returns the blocks in the order they are numbered
+            */
+            ArrayRef<BasicBlock*> getOrder() const {
+                return order;
+            }
+
+            unsigned getNumVisits() const {
+                return visits;
+            }
+
+            unsigned getNumRounds() const {
+                return rounds;
+            }
+
+        private:
+            DataflowDirection direction;
+
+            std::vector<BasicBlock*> order;
+            DenseMap<BasicBlock*, unsigned> index;
+
+            std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>> queue;
+            BitVector queued;
+
+            unsigned last = 0;
+            unsigned visits = 0;
+            unsigned rounds = 0;
+    };
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_DATAFLOWWORKLIST_H
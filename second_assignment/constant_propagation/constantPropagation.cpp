@@ -1,276 +1,430 @@
 #include "constantPropagation.hpp"
-
-#define INFINITY 2147483647
+#include "valueRange.hpp"
 
 using namespace llvm;
 
-/**
-    Computes the intersetction between two maps
+#define DEBUG_TYPE "constant-propagation"
 
-    It is used in blockConstants function in order to obtain the input map
-    from predecessors
-*/
-std::map<Value*, int> computeIntersection(BasicBlock &BB, std::map<BasicBlock*, std::map<Value*, int>> &blocksConstants) {
-    bool isFirst = true;
-    std::map<Value*, int> res;
+STATISTIC(NumBlockVisits, "Number of basic block visits of the constant propagation");
 
-    for (BasicBlock *pred : predecessors(&BB)) {
-        if (blocksConstants.find(pred) == blocksConstants.end()) continue;
+bool LatticeValue::meet(const LatticeValue &other) {
+    if (other.isUndefined() || isOverdefined() || *this == other) return false;
 
-        if (BB.getName() == "while") outs() << pred->getName() << "\n";
+    if (isUndefined()) *this = other;
+    else *this = getOverdefined();
 
-        if (isFirst) {
-            res = blocksConstants[pred];
-            isFirst = false;
-        } else {
-            std::map<Value*, int> temp;
+    return true;
+}
 
-            for (auto &rPair : res) {
-                for (auto &pPair : blocksConstants[pred]) {
-                    if (rPair == pPair) temp[rPair.first] = rPair.second;
-                }
-            }
+LatticeValue LatticeValue::get(llvm::Constant *C) {
+    if (isa<ConstantInt>(C) || isa<ConstantFP>(C)) return {Constant, C};
+
+    if (isa<UndefValue>(C)) return LatticeValue();
+
+    return getOverdefined();
+}
+
+ConstantPropagationSolver::ConstantPropagationSolver(Function &F, const ReturnValueMap *returnValues) :
+    F(F), DL(F.getParent()->getDataLayout()), returnValues(returnValues), blockWorklist(F, DataflowDirection::Forward) {
+    for (Instruction &inst : instructions(F)) {
+        AllocaInst *AI = dyn_cast<AllocaInst>(&inst);
 
-            res = temp;
+        if (AI && isAllocaPromotable(AI)) {
+            variableIndex[AI] = variables.size();
+            variables.push_back(AI);
         }
     }
+}
+
+LatticeValue ConstantPropagationSolver::getValue(Value *V) const {
+    // Undef and poison can be assumed to be any constant
+    if (Constant *C = dyn_cast<Constant>(V)) return LatticeValue::get(C);
+
+    auto it = values.find(V);
+    if (it != values.end()) return it->second;
 
-    return res;
+    // Arguments are overdefined unless they were given a value
+    return isa<Instruction>(V) ? LatticeValue() : LatticeValue::getOverdefined();
 }
 
-/**
-    Returns the first instruction to be a load.
-    If both instruction are not LoadInst, nullptr is returned
-*/
-LoadInst* getLoad(Value *inst1, Value *inst2) {
-    LoadInst *load1 = dyn_cast<LoadInst>(inst1);
-    LoadInst *load2 = dyn_cast<LoadInst>(inst2);
+LatticeValue ConstantPropagationSolver::getReturnValue() const {
+    LatticeValue V;
+
+    for (BasicBlock &BB : F) {
+        ReturnInst *RI = dyn_cast<ReturnInst>(BB.getTerminator());
+
+        if (RI && RI->getReturnValue() && isExecutable(&BB)) V.meet(getValue(RI->getReturnValue()));
+    }
+
+    return V;
+}
+
+Constant *ConstantPropagationSolver::getConstant(Value *V) const {
+    LatticeValue lattice = getValue(V);
+
+    return lattice.isConstant() ? lattice.value : nullptr;
+}
 
-    return load1 ? load1 : load2;
+void ConstantPropagationSolver::pushBlock(BasicBlock *BB) {
+    blockWorklist.push(BB);
 }
 
 /**
-    Returns true if both instruction are LoadInst, false otherwise
+    Marks a CFG edge as feasible.
+
+    The destination block is visited (again): it may have become executable, and
+    both its PHIs and its input memory state depend on the feasible incoming edges
 */
-bool bothLoad(Value *lhs, Value *rhs) {
-    if (dyn_cast<LoadInst>(lhs) && dyn_cast<LoadInst>(rhs)) return true;
+void ConstantPropagationSolver::markEdgeFeasible(BasicBlock *from, BasicBlock *to) {
+    if (!feasibleEdges.insert({from, to}).second) return;
 
-    return false;
+    executableBlocks.insert(to);
+    pushBlock(to);
 }
 
 /**
-    Helper function used to perform the right algebric operation
-    based on the instruction opcode.
+    Lowers the lattice value of an instruction, enqueueing its users if it changed
 */
-int performOp(int val1, int val2, uint64_t opCode) {
-    int res = INFINITY;
+void ConstantPropagationSolver::updateValue(Instruction &inst, LatticeValue V) {
+    if (!values[&inst].meet(V)) return;
 
-    switch (opCode) {
-        case Instruction::Add:
-            res = val1 + val2;
-        break;
+    for (User *U : inst.users()) {
+        Instruction *userInst = cast<Instruction>(U);
 
-        case Instruction::Sub:
-            res = val1 - val2;
-        break;
+        if (isExecutable(userInst->getParent())) instWorklist.push_back(userInst);
+    }
+}
 
-        case Instruction::Mul:
-            res = val1 * val2;
-        break;
+/**
+    Computes the memory state at the beginning of a block, as the meet of the
+    memory states at the end of the predecessors whose edge is feasible
+*/
+MemoryState ConstantPropagationSolver::computeBlockInput(BasicBlock &BB) {
+    MemoryState memory(variables.size());
+
+    for (BasicBlock *pred : predecessors(&BB)) {
+        if (!isEdgeFeasible(pred, &BB)) continue;
 
-        case Instruction::SDiv:
-        case Instruction::UDiv:
-            res = val1 / val2;
-        break;
+        auto it = blockOut.find(pred);
+        if (it == blockOut.end()) continue;
 
-        default:
-        break;
+        for (unsigned i = 0; i < variables.size(); i++) {
+            memory[i].meet(it->second[i]);
+        }
     }
 
-    return res;
+    return memory;
 }
 
 /**
-    Returns true if the given argument is the first
-    in the instruction
+    Visits an executable block, following the stores to the tracked variables.
+    If the memory state at the end of the block changes, the successors reached
+    through a feasible edge are visited again.
+
+    The lattice values of the instructions act as a memo table: a block is visited
+    again only because a new incoming edge became feasible or its input memory
+    state changed, which can only change its PHIs and its loads. The other
+    instructions keep their value, and are evaluated again through the
+    instruction worklist only when one of their operands changes, so the
+    operations of long blocks are not folded again at every visit
 */
-bool isFirst(Instruction &inst, Value *V) {
-    return inst.getOperand(0) == V;
+void ConstantPropagationSolver::visitBlock(BasicBlock &BB) {
+    MemoryState memory = computeBlockInput(BB);
+    auto it = blockOut.find(&BB);
+    bool isFirstVisit = it == blockOut.end();
+
+    for (Instruction &inst : BB) {
+        if (isFirstVisit || isa<PHINode>(inst) || isa<LoadInst>(inst) || isa<StoreInst>(inst)) {
+            visitInstruction(inst, &memory);
+        }
+    }
+
+    if (isFirstVisit || it->second != memory) {
+        blockOut[&BB] = std::move(memory);
+
+        for (BasicBlock *succ : successors(&BB)) {
+            if (isEdgeFeasible(&BB, succ)) pushBlock(succ);
+        }
+    }
 }
 
 /**
-    Recursive function that computes the constant value to add to the constants map
+    Computes the lattice value of an instruction from the ones of its operands.
 
-    Makes use of llvm PatternMatch module in order to find binary operations of the type:
-    - Value ⊕ Value
-    - Value ⊕ Constant
+    Loads and stores of the tracked variables read and update the memory state
+    of the block being visited, so they are only evaluated by visitBlock()
+*/
+void ConstantPropagationSolver::visitInstruction(Instruction &inst, MemoryState *memory) {
+    if (inst.isTerminator()) {
+        visitTerminator(inst);
+        return;
+    }
 
-    Base case:
-        - val1 ⊕ val2 ==> both operands in the instructions are known constants.
-            The result of the operation is returned
-        - the instruction does not respect the criteria ==> returns INFINITY
+    if (PHINode *phi = dyn_cast<PHINode>(&inst)) {
+        LatticeValue V;
 
-    Recursive case:
-        - One of the two operand is an instruction different from load ==>
-            calls the function with the operand instruction as the inst argument
-*/
-int computeConstant(Instruction &inst, std::map<Value*, int> &blockConstants) {
-    Value* LHS = nullptr;
-    Value* RHS = nullptr;
-    ConstantInt *C = nullptr;
-
-    int val1 = INFINITY;
-    int val2 = INFINITY;
-    uint64_t opCode = inst.getOpcode();
-    bool isVal1First = false;
-
-    if (
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(LHS), PatternMatch::m_ConstantInt(C))) ||
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_ConstantInt(C), PatternMatch::m_Value(LHS))) ||
-        PatternMatch::match(&inst, PatternMatch::m_BinOp(PatternMatch::m_Value(LHS), PatternMatch::m_Value(RHS)))
-    ) {
-
-        if (C) {
-            if (LoadInst *LI = dyn_cast<LoadInst>(LHS)) {
-                Value* ptr = LI->getPointerOperand();
-
-                if (blockConstants.find(ptr) != blockConstants.end()) {
-                    val1 = blockConstants[ptr];
-                }
-            } else if (Instruction *opInst = dyn_cast<Instruction>(LHS)) {
-                val1 = computeConstant(*opInst, blockConstants);
+        for (unsigned i = 0; i < phi->getNumIncomingValues(); i++) {
+            if (isEdgeFeasible(phi->getIncomingBlock(i), phi->getParent())) {
+                V.meet(getValue(phi->getIncomingValue(i)));
             }
+        }
 
-            val2 = C->getSExtValue();
+        updateValue(inst, V);
+        return;
+    }
 
-            if (isFirst(inst, LHS)) isVal1First = true;
+    if (StoreInst *SI = dyn_cast<StoreInst>(&inst)) {
+        auto it = variableIndex.find(SI->getPointerOperand());
 
-        } else if (bothLoad(LHS, RHS)) {
-            LoadInst *lhsLoad = cast<LoadInst>(LHS);
-            LoadInst *rhsLoad = cast<LoadInst>(RHS);
+        if (it != variableIndex.end()) (*memory)[it->second] = getValue(SI->getValueOperand());
 
-            Value *lhsPtr = lhsLoad->getPointerOperand();
-            Value *rhsPtr = rhsLoad->getPointerOperand();
+        return;
+    }
 
-            if (
-                blockConstants.find(lhsPtr) != blockConstants.end() &&
-                blockConstants.find(rhsPtr) != blockConstants.end()
-            ) {
-                val1 = blockConstants[lhsPtr];
-                val2 = blockConstants[rhsPtr];
+    if (LoadInst *LI = dyn_cast<LoadInst>(&inst)) {
+        auto it = variableIndex.find(LI->getPointerOperand());
 
-                isVal1First = true;
-            }
-        } else if (LoadInst *LI = getLoad(LHS, RHS)) {
-            Value *nonLoad = LI == LHS ? RHS : LHS;
-            Instruction *nonLoadInst = dyn_cast<Instruction>(nonLoad);
-            Value *ptr = LI->getPointerOperand();
+        if (it != variableIndex.end()) updateValue(inst, (*memory)[it->second]);
+        else updateValue(inst, LatticeValue::getOverdefined());
 
-            if (nonLoadInst && blockConstants.find(ptr) != blockConstants.end()) {
-                val1 = blockConstants[ptr];
-                val2 = computeConstant(*nonLoadInst, blockConstants);
+        return;
+    }
 
-                if (LI == LHS) isVal1First = true;
-            }
+    if (SelectInst *select = dyn_cast<SelectInst>(&inst)) {
+        LatticeValue cond = getValue(select->getCondition());
+
+        // The arm that is not selected does not matter, even if it is overdefined
+        if (cond.isConstant()) {
+            updateValue(inst, getValue(cond.getInt().isZero() ? select->getFalseValue() : select->getTrueValue()));
+        } else if (cond.isOverdefined()) {
+            LatticeValue V = getValue(select->getTrueValue());
+            V.meet(getValue(select->getFalseValue()));
+
+            updateValue(inst, V);
         }
+
+        return;
+    }
+
+    if (isa<BinaryOperator>(inst) || isa<UnaryOperator>(inst) || isa<CastInst>(inst) || isa<CmpInst>(inst)) {
+        updateValue(inst, evaluate(inst));
+        return;
     }
 
-    if (val1 != INFINITY && val2 != INFINITY) {
-        if (isVal1First) return performOp(val1, val2, opCode);
-        else return performOp(val2, val1, opCode);
+    if (CallBase *call = dyn_cast<CallBase>(&inst); call && returnValues) {
+        auto it = returnValues->find(call->getCalledFunction());
+
+        if (it != returnValues->end() && call->getFunctionType() == it->first->getFunctionType()) {
+            updateValue(inst, it->second);
+            return;
+        }
     }
 
-    return INFINITY;
+    if (!inst.getType()->isVoidTy()) updateValue(inst, LatticeValue::getOverdefined());
 }
 
 /**
-    Computes the constants for the given block.
-
-    Returns true if the block's constants were changed, false otherwise
+    Evaluates an operation, a cast or a comparison with the constant folding of LLVM,
+    which knows the semantics of every opcode on every integer width and floating
+    point type.
+
+    The result is undefined until all the operands are known, and overdefined if
+    one of them is overdefined or if the operation has no defined result on its
+    operands (e.g. a division by zero, which folds to poison). Literal undef and
+    poison operands are folded as they are once the other operands are known,
+    since the result may not depend on them (and i32 undef, 0 is always 0)
 */
-bool blockConstants(BasicBlock &BB, std::map<BasicBlock*, std::map<Value*, int>> &blocksConstants) {
-    bool isChanged = false;
-    std::map<Value*, int> blockConstants = computeIntersection(BB, blocksConstants);
+LatticeValue ConstantPropagationSolver::evaluate(Instruction &inst) {
+    SmallVector<Constant*, 2> operands;
 
-    for (Instruction &inst : BB) {
-        if (StoreInst *SI = dyn_cast<StoreInst>(&inst)) {
-            Value* ptr = SI->getPointerOperand();
-            Value* V = SI->getValueOperand();
-
-            if (ConstantInt *C = dyn_cast<ConstantInt>(V)) {
-                blockConstants[ptr] = C->getSExtValue();
-            } else if (LoadInst *LI = dyn_cast<LoadInst>(V)) {
-                if (blockConstants.find(LI->getPointerOperand()) != blockConstants.end()) {
-                    blockConstants[ptr] = blockConstants[LI->getPointerOperand()];
-                }
-            } else if (Instruction *vInst = dyn_cast<Instruction>(V)) {
-                int constValue = computeConstant(*vInst, blockConstants);
-
-                if (constValue != INFINITY) blockConstants[ptr] = constValue;
-            }
-        } else {
+    for (Value *op : inst.operands()) {
+        if (UndefValue *undef = dyn_cast<UndefValue>(op)) {
+            operands.push_back(undef);
             continue;
         }
+
+        LatticeValue V = getValue(op);
+
+        if (V.isOverdefined()) return V;
+        if (V.isUndefined()) return LatticeValue();
+
+        operands.push_back(V.value);
     }
 
-    if (blockConstants != blocksConstants[&BB]) {
-        blocksConstants[&BB] = blockConstants;
-        isChanged = true;
+    Constant *C = nullptr;
+
+    if (CmpInst *cmp = dyn_cast<CmpInst>(&inst)) {
+        C = ConstantFoldCompareInstOperands(cmp->getPredicate(), operands[0], operands[1], DL);
+    } else if (isa<CastInst>(inst)) {
+        C = ConstantFoldCastOperand(inst.getOpcode(), operands[0], inst.getType(), DL);
+    } else if (isa<UnaryOperator>(inst)) {
+        C = ConstantFoldUnaryOpOperand(inst.getOpcode(), operands[0], DL);
+    } else {
+        C = ConstantFoldBinaryOpOperands(inst.getOpcode(), operands[0], operands[1], DL);
     }
 
-    return isChanged;
+    if (!C || isa<UndefValue>(C)) return LatticeValue::getOverdefined();
+
+    return LatticeValue::get(C);
 }
 
 /**
-    Computes constant propagation information for the given function
+    Marks the outgoing edges the terminator of an executable block can take:
+    only one if its condition is constant, none while it is undefined
+*/
+void ConstantPropagationSolver::visitTerminator(Instruction &inst) {
+    BasicBlock *BB = inst.getParent();
+
+    if (BranchInst *BI = dyn_cast<BranchInst>(&inst)) {
+        if (BI->isConditional()) {
+            LatticeValue cond = getValue(BI->getCondition());
+
+            if (cond.isConstant()) {
+                markEdgeFeasible(BB, BI->getSuccessor(cond.getInt().isZero() ? 1 : 0));
+                return;
+            }
+
+            if (cond.isUndefined()) return;
+        }
+    } else if (SwitchInst *SI = dyn_cast<SwitchInst>(&inst)) {
+        LatticeValue cond = getValue(SI->getCondition());
+
+        if (cond.isConstant()) {
+            BasicBlock *dest = SI->getDefaultDest();
+
+            for (auto &c : SI->cases()) {
+                if (c.getCaseValue() == cond.value) {
+                    dest = c.getCaseSuccessor();
+                    break;
+                }
+            }
+
+            markEdgeFeasible(BB, dest);
+            return;
+        }
+
+        if (cond.isUndefined()) return;
+    }
+
+    for (BasicBlock *succ : successors(BB)) {
+        markEdgeFeasible(BB, succ);
+    }
+}
 
-    Returns true if at least one block's constant have been changed
+/**
+    Makes all the edges of the executable terminators feasible if their condition
+    is still undefined at the fixed point, like the resolution of the undefined
+    values of LLVM's SCCP. The condition may depend on an undef the folding could
+    not see through (e.g. the load of a variable never stored), so branching on
+    it is not known to be undefined behavior: only the terminators on a literal
+    undef or poison are left without a feasible edge.
+
+    Returns true if an edge became feasible
 */
-bool constantPropagation(Function &F, std::map<BasicBlock*, std::map<Value*, int>> &blocksConstants) {
-    bool transformed = false;
+bool ConstantPropagationSolver::resolveUndefinedBranches() {
+    bool resolved = false;
 
     for (BasicBlock &BB : F) {
-        if (blockConstants(BB, blocksConstants)) transformed = true;
+        if (!isExecutable(&BB)) continue;
+
+        Instruction *terminator = BB.getTerminator();
+        Value *cond = nullptr;
+
+        if (BranchInst *BI = dyn_cast<BranchInst>(terminator); BI && BI->isConditional()) cond = BI->getCondition();
+        else if (SwitchInst *SI = dyn_cast<SwitchInst>(terminator)) cond = SI->getCondition();
+
+        if (!cond || isa<UndefValue>(cond) || !getValue(cond).isUndefined()) continue;
+
+        for (BasicBlock *succ : successors(&BB)) {
+            if (isEdgeFeasible(&BB, succ)) continue;
+
+            markEdgeFeasible(&BB, succ);
+            resolved = true;
+        }
     }
 
-    return transformed;
+    return resolved;
 }
 
-void printIterationInfo(std::map<BasicBlock*, std::map<Value*, int>> &blocksConstants, int iteration) {
-    outs() << "Output after iteration " << iteration << "\n\n";
+/**
+    Solves the constant propagation problem for the function.
+
+    The entry block is the only executable one at the beginning. Instructions
+    are re-evaluated when one of their operands changes, and blocks are visited
+    again only when a new incoming edge becomes feasible or their input memory
+    state changes, so every lattice value is lowered at most twice.
+
+    At the fixed point, the branches on a condition that is still undefined are
+    resolved (see resolveUndefinedBranches()) and the solver goes on from the
+    blocks they make executable, unless resolveUndefined is false: the
+    interprocedural mode only resolves them once the arguments of all the
+    functions are known
+*/
+void ConstantPropagationSolver::solve(bool resolveUndefined) {
+    if (F.isDeclaration()) return;
+
+    executableBlocks.insert(&F.getEntryBlock());
+    pushBlock(&F.getEntryBlock());
 
-    for (auto &pair : blocksConstants) {
-        outs() << "Constants for basic block: " << pair.first->getName() << "\n";
+    do {
+        while (!blockWorklist.empty() || !instWorklist.empty()) {
+            while (!instWorklist.empty()) {
+                Instruction *inst = instWorklist.pop_back_val();
+
+                if (isa<LoadInst>(inst) || isa<StoreInst>(inst)) pushBlock(inst->getParent());
+                else visitInstruction(*inst, nullptr);
+            }
 
-        for (auto &constPair : pair.second) {
-            constPair.first->print(outs());
-            outs() << ": " << constPair.second << "\n";
+            // The inputs of a block are known before it is visited, except along back edges
+            if (!blockWorklist.empty()) visitBlock(*blockWorklist.pop());
         }
+    } while (resolveUndefined && resolveUndefinedBranches());
 
-        outs() << "\n";
-    }
+    NumBlockVisits += blockWorklist.getNumVisits();
+}
+
+AnalysisKey ConstantPropagationAnalysis::Key;
 
-    outs() << "-------------------\n\n";
+ConstantPropagationSolver ConstantPropagationAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+    ConstantPropagationSolver solver(F);
+    solver.solve();
+
+    return solver;
 }
 
 PreservedAnalyses ConstantPropagation::run(Module &M, ModuleAnalysisManager &AM) {
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
     // Run optimizations on each function in the module
     for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
-        std::map<BasicBlock*, std::map<Value*, int>> blocksConstants;
-        int n = 0;
+        if (Fiter->isDeclaration()) continue;
 
-        while (constantPropagation(*Fiter, blocksConstants)) { printIterationInfo(blocksConstants, n); n++; };
+        ConstantPropagationSolver &solver = FAM.getResult<ConstantPropagationAnalysis>(*Fiter);
 
         outs() << "Constants for function: " << Fiter->getName();
         outs() << "\n\n";
 
-        for (auto &pair : blocksConstants) {
-            outs() << "Constant propagation for basic block: " << pair.first->getName();
+        for (BasicBlock &BB : *Fiter) {
+            if (!solver.isExecutable(&BB)) {
+                outs() << "Unreachable basic block: ";
+                BB.printAsOperand(outs(), false);
+                outs() << "\n\n";
+                continue;
+            }
+
+            outs() << "Constant propagation for basic block: ";
+            BB.printAsOperand(outs(), false);
             outs() << "\n";
 
-            for (auto &constPair : pair.second) {
-                constPair.first->print(outs());
-                outs() << ": " << constPair.second << "\n";
+            const MemoryState &memory = solver.getBlockConstants(&BB);
+
+            for (unsigned i = 0; i < memory.size(); i++) {
+                if (!memory[i].isConstant()) continue;
+
+                solver.getVariables()[i]->print(outs());
+                outs() << ": ";
+                memory[i].value->printAsOperand(outs(), false);
+                outs() << "\n";
             }
 
             outs() << "\n";
@@ -282,10 +436,137 @@ PreservedAnalyses ConstantPropagation::run(Module &M, ModuleAnalysisManager &AM)
     return PreservedAnalyses::all();
 }
 
+/**
+    Rewrites a function with the result of the constant propagation:
+    - instructions proven constant (loads of the variables included) are replaced
+      with the constant, and erased if they have no side effects
+    - so are the arguments proven constant by the interprocedural mode
+    - conditional branches and switches on a constant condition become unconditional,
+      and so do the conditional branches with a single feasible edge
+    - branches on a literal undef or poison condition, which the solver leaves
+      without a feasible edge, are unreachable
+    - blocks that can never be executed are deleted
+
+    Returns true if the function was changed
+*/
+template <typename Solver>
+bool llvm::transformFunction(Function &F, const Solver &solver) {
+    bool transformed = false;
+    SmallVector<Instruction*, 32> deadInsts;
+    SmallVector<BasicBlock*, 16> deadBlocks;
+
+    for (Argument &arg : F.args()) {
+        Constant *C = solver.getConstant(&arg);
+
+        if (C && !arg.use_empty()) {
+            arg.replaceAllUsesWith(C);
+            transformed = true;
+        }
+    }
+
+    for (BasicBlock &BB : F) {
+        if (!solver.isExecutable(&BB)) {
+            deadBlocks.push_back(&BB);
+            continue;
+        }
+
+        for (Instruction &inst : BB) {
+            Constant *C = solver.getConstant(&inst);
+            if (!C) continue;
+
+            // The result of a musttail call must be returned as is
+            CallInst *call = dyn_cast<CallInst>(&inst);
+            if (call && call->isMustTailCall()) continue;
+
+            inst.replaceAllUsesWith(C);
+            transformed = true;
+
+            if (isInstructionTriviallyDead(&inst)) deadInsts.push_back(&inst);
+        }
+    }
+
+    for (Instruction *inst : deadInsts) {
+        inst->eraseFromParent();
+    }
+
+    for (BasicBlock &BB : F) {
+        if (!solver.isExecutable(&BB)) continue;
+
+        Instruction *terminator = BB.getTerminator();
+        bool hasFeasibleEdge = false;
+
+        for (BasicBlock *succ : successors(&BB)) {
+            if (solver.isEdgeFeasible(&BB, succ)) hasFeasibleEdge = true;
+        }
+
+        BranchInst *BI = dyn_cast<BranchInst>(terminator);
+        Value *cond = nullptr;
+
+        if (BI && BI->isConditional()) cond = BI->getCondition();
+        else if (SwitchInst *SI = dyn_cast<SwitchInst>(terminator)) cond = SI->getCondition();
+
+        if (!hasFeasibleEdge && cond && isa<UndefValue>(cond)) {
+            // Branching on undef or poison is undefined behavior
+            for (BasicBlock *succ : successors(&BB)) {
+                succ->removePredecessor(&BB);
+            }
+
+            terminator->eraseFromParent();
+            new UnreachableInst(F.getContext(), &BB);
+            transformed = true;
+        } else if (
+            BI && BI->isConditional() && BI->getSuccessor(0) != BI->getSuccessor(1) &&
+            solver.isEdgeFeasible(&BB, BI->getSuccessor(0)) != solver.isEdgeFeasible(&BB, BI->getSuccessor(1))
+        ) {
+            // The value ranges can prove an edge infeasible without a constant condition
+            unsigned taken = solver.isEdgeFeasible(&BB, BI->getSuccessor(0)) ? 0 : 1;
+
+            BI->getSuccessor(1 - taken)->removePredecessor(&BB);
+            BranchInst::Create(BI->getSuccessor(taken), BI);
+            BI->eraseFromParent();
+            transformed = true;
+        } else if (ConstantFoldTerminator(&BB, true)) {
+            transformed = true;
+        }
+    }
+
+    if (!deadBlocks.empty()) {
+        DeleteDeadBlocks(deadBlocks);
+        transformed = true;
+    }
+
+    return transformed;
+}
+
+template bool llvm::transformFunction(Function &F, const ConstantPropagationSolver &solver);
+template bool llvm::transformFunction(Function &F, const ValueRangeSolver &solver);
+
+PreservedAnalyses ConstantPropagationTransform::run(Module &M, ModuleAnalysisManager &AM) {
+    bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
+        if (Fiter->isDeclaration()) continue;
+
+        if (transformFunction(*Fiter, FAM.getResult<ConstantPropagationAnalysis>(*Fiter))) {
+            transformed = true;
+        }
+    }
+
+    if (transformed) return PreservedAnalyses::none();
+
+    return PreservedAnalyses::all();
+}
 
 PassPluginLibraryInfo getConstantPropagationPluginInfo() {
     return {LLVM_PLUGIN_API_VERSION, "Constant Propagation", LLVM_VERSION_STRING,
         [](PassBuilder &PB) {
+            PB.registerAnalysisRegistrationCallback(
+                [](FunctionAnalysisManager &FAM) {
+                    FAM.registerPass([] { return ConstantPropagationAnalysis(); });
+                    FAM.registerPass([] { return ValueRangeAnalysis(); });
+                });
+
             // Register the pass with the pass builder
             PB.registerPipelineParsingCallback(
                 [](StringRef Name, ModulePassManager &MPM,
@@ -294,6 +575,22 @@ PassPluginLibraryInfo getConstantPropagationPluginInfo() {
                         MPM.addPass(ConstantPropagation());
                         return true;
                     }
+                    if (Name == "constant-propagation-transform") {
+                        MPM.addPass(ConstantPropagationTransform());
+                        return true;
+                    }
+                    if (Name == "interprocedural-constant-propagation") {
+                        MPM.addPass(InterproceduralConstantPropagation());
+                        return true;
+                    }
+                    if (Name == "value-range") {
+                        MPM.addPass(ValueRange());
+                        return true;
+                    }
+                    if (Name == "value-range-transform") {
+                        MPM.addPass(ValueRangeTransform());
+                        return true;
+                    }
                     return false;
                 });
         }};
@@ -5,17 +5,226 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Value.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/IR/PatternMatch.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+#include "../common/dataflowWorklist.hpp"
 
 #include <map>
+#include <vector>
 
 namespace llvm {
+    /**
+        Value of the three-level constant propagation lattice:
+        - Undefined: no value has reached it yet (top)
+        - Constant: it always holds the same value
+        - Overdefined: it may hold different values (bottom)
+
+        Constants are kept as the ConstantInt or ConstantFP of their type, i.e. an APInt
+        of the width of the integer or an APFloat of the floating point semantics. LLVM
+        uniques them, so two constant lattice values are equal if they hold the same pointer
+    */
+    struct LatticeValue {
+        enum State { Undefined, Constant, Overdefined };
+
+        State state = Undefined;
+        llvm::Constant *value = nullptr;
+
+        /**
+            Returns the lattice value of a constant: integer and floating point scalars are
+            constant, undef and poison are undefined, every other constant is overdefined
+        */
+        static LatticeValue get(llvm::Constant *C);
+
+        static LatticeValue getOverdefined() {
+            return {Overdefined, nullptr};
+        }
+
+        bool isUndefined() const { return state == Undefined; }
+        bool isConstant() const { return state == Constant; }
+        bool isOverdefined() const { return state == Overdefined; }
+
+        const APInt &getInt() const {
+            return cast<ConstantInt>(value)->getValue();
+        }
+
+        const APFloat &getFloat() const {
+            return cast<ConstantFP>(value)->getValueAPF();
+        }
+
+        bool operator==(const LatticeValue &other) const {
+            return state == other.state && value == other.value;
+        }
+
+        bool operator!=(const LatticeValue &other) const {
+            return !(*this == other);
+        }
+
+        /**
+            Lowers this value to the meet of itself and other.
+
+            Returns true if the value was changed
+        */
+        bool meet(const LatticeValue &other);
+    };
+
+    /**
+        Lattice values of the tracked variables, indexed by variable number
+    */
+    using MemoryState = std::vector<LatticeValue>;
+
+    /**
+        Lattice values of the return values of the functions of a module, used by the
+        interprocedural mode to give a value to the direct calls
+    */
+    using ReturnValueMap = DenseMap<Function*, LatticeValue>;
+
+    /**
+        Sparse conditional constant propagation (Wegman and Zadeck) on a function.
+
+        Every SSA value gets a lattice value, and every CFG edge is feasible only once
+        the branch it comes from has been proven to take it, so the values flowing
+        from unreachable blocks never lower the result of a PHI or of a variable.
+
+        The local variables of unoptimized code live in allocas: the ones only
+        accessed by loads and stores (the ones mem2reg would promote) are tracked
+        too, with a memory state at the end of every block.
+
+        On its own the solver knows nothing about the arguments and the results of
+        the calls, which are overdefined. The interprocedural mode seeds the arguments
+        with the values coming from the call sites, and gives the direct calls the
+        value returned by the callee.
+    */
+    class ConstantPropagationSolver {
+        public:
+            explicit ConstantPropagationSolver(Function &F, const ReturnValueMap *returnValues = nullptr);
+
+            /**
+                Sets the value of an argument, before solving
+            */
+            void setArgumentValue(Argument *arg, LatticeValue V) {
+                values[arg] = V;
+            }
+
+            void solve(bool resolveUndefined = true);
+
+            /**
+                Returns the meet of the values returned by the executable blocks
+            */
+            LatticeValue getReturnValue() const;
+
+            LatticeValue getValue(Value *V) const;
+
+            /**
+                Returns the constant a value was proven to hold, nullptr if it is not constant
+            */
+            Constant *getConstant(Value *V) const;
+
+            bool isExecutable(BasicBlock *BB) const {
+                return executableBlocks.count(BB);
+            }
+
+            bool isEdgeFeasible(BasicBlock *from, BasicBlock *to) const {
+                return feasibleEdges.count({from, to});
+            }
+
+            ArrayRef<AllocaInst*> getVariables() const {
+                return variables;
+            }
+
+            /**
+                Returns the values of the variables at the end of an executable block
+            */
+            const MemoryState &getBlockConstants(BasicBlock *BB) const {
+                return blockOut.find(BB)->second;
+            }
+
+        private:
+            Function &F;
+            const DataLayout &DL;
+            const ReturnValueMap *returnValues;
+
+            SmallVector<AllocaInst*, 16> variables;
+            DenseMap<Value*, unsigned> variableIndex;
+
+            DenseMap<Value*, LatticeValue> values;
+            SmallPtrSet<BasicBlock*, 32> executableBlocks;
+            DenseSet<std::pair<BasicBlock*, BasicBlock*>> feasibleEdges;
+            DenseMap<BasicBlock*, MemoryState> blockOut;
+
+            // Blocks to be (re)visited as a whole, because they became executable or their
+            // input memory state changed, in reverse post-order, and instructions whose
+            // operands changed
+            DataflowWorklist blockWorklist;
+            SmallVector<Instruction*, 64> instWorklist;
+
+            void pushBlock(BasicBlock *BB);
+            void markEdgeFeasible(BasicBlock *from, BasicBlock *to);
+            void updateValue(Instruction &inst, LatticeValue V);
+
+            MemoryState computeBlockInput(BasicBlock &BB);
+            void visitBlock(BasicBlock &BB);
+            void visitInstruction(Instruction &inst, MemoryState *memory);
+            void visitTerminator(Instruction &inst);
+            bool resolveUndefinedBranches();
+
+            LatticeValue evaluate(Instruction &inst);
+    };
+
+    /**
+        Function analysis wrapping the solver, so that the printer and the transformation
+        share the same result instead of solving the function again
+    */
+    class ConstantPropagationAnalysis : public AnalysisInfoMixin<ConstantPropagationAnalysis> {
+        friend AnalysisInfoMixin<ConstantPropagationAnalysis>;
+        static AnalysisKey Key;
+
+        public:
+            using Result = ConstantPropagationSolver;
+
+            Result run(Function &F, FunctionAnalysisManager &FAM);
+    };
+
     class ConstantPropagation : public PassInfoMixin<ConstantPropagation> {
         public:
             PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
     };
+
+    class ConstantPropagationTransform : public PassInfoMixin<ConstantPropagationTransform> {
+        public:
+            PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+    };
+
+    /**
+        Interprocedural constant propagation: the constants flow from the call sites
+        to the arguments of the callees, and from the return values of the callees
+        back to the call sites
+    */
+    class InterproceduralConstantPropagation : public PassInfoMixin<InterproceduralConstantPropagation> {
+        public:
+            PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+    };
+
+    /**
+        Rewrites a function with the result of a solver, shared by the transformations of
+        the constant propagation (intraprocedural and interprocedural) and of the value
+        ranges. The solver provides getConstant(), isExecutable() and isEdgeFeasible()
+    */
+    template <typename Solver>
+    bool transformFunction(Function &F, const Solver &solver);
 } // namespace llvm
 
 #endif // LLVM_TRANSFORMS_TESTPASS _H
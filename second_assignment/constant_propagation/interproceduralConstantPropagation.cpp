@@ -0,0 +1,437 @@
+#include "constantPropagation.hpp"
+
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include <deque>
+#include <memory>
+
+using namespace llvm;
+
+/**
+    Command-line option that enables the specialization of the functions on the
+    constant arguments of their call sites.
+
+    Use with `-ipcp-specialize` when running the LLVM opt tool.
+*/
+static cl::opt<bool> SpecializeFunctions(
+    "ipcp-specialize",
+    cl::desc("Clone the functions called with constant arguments the propagation cannot bind to the function itself"),
+    cl::init(false)
+);
+
+/**
+    Command-line option that limits the size, in instructions, of the functions
+    that can be cloned by the specialization.
+
+    Use with `-ipcp-specialize-max-size=<n>` when running the LLVM opt tool.
+*/
+static cl::opt<unsigned> SpecializationMaxSize(
+    "ipcp-specialize-max-size",
+    cl::desc("Maximum number of instructions of a function cloned by the specialization"),
+    cl::init(500)
+);
+
+/**
+    Command-line option that limits the number of specialized copies of a function.
+
+    Use with `-ipcp-specialize-max-clones=<n>` when running the LLVM opt tool.
+*/
+static cl::opt<unsigned> SpecializationMaxClones(
+    "ipcp-specialize-max-clones",
+    cl::desc("Maximum number of specialized copies of a function"),
+    cl::init(4)
+);
+
+/**
+    Command-line option that limits the number of instructions the specialization
+    adds to the whole module.
+
+    Use with `-ipcp-specialize-budget=<n>` when running the LLVM opt tool.
+*/
+static cl::opt<unsigned> SpecializationBudget(
+    "ipcp-specialize-budget",
+    cl::desc("Maximum number of instructions added to the module by the specialization"),
+    cl::init(5000)
+);
+
+namespace {
+    /**
+        Constant propagation over the call graph of a module.
+
+        Every defined function is solved. The ones with an exact definition have a
+        summary, the lattice value of what they return, which the solvers of their
+        callers give to the direct calls: another definition may replace the other
+        ones at link time (e.g. linkonce_odr), so they are only solved for the values
+        they pass to their callees. The functions whose call sites are all known (local
+        linkage, address never taken, and only called by functions that are solved)
+        also get the lattice values of their arguments, as the meet of the values passed
+        by the executable call sites.
+
+        Both start undefined and are only lowered, like the values inside a function.
+        The functions are solved bottom-up in the call graph first, so the callers
+        already see the summaries of their callees, then a function is solved again
+        whenever the summary of one of its callees or one of its arguments changes:
+        return values flow up to the callers, arguments flow down to the callees.
+
+        The branches on a condition that is still undefined are only resolved once
+        nothing changes (see ConstantPropagationSolver::solve()): before, an argument
+        may be undefined only because its call sites were not solved yet. Every
+        function is then solved again with the resolution, until nothing changes.
+    */
+    class InterproceduralSolver {
+        public:
+            explicit InterproceduralSolver(Module &M);
+
+            void solve();
+
+            const ConstantPropagationSolver *getSolver(Function *F) const {
+                auto it = solvers.find(F);
+
+                return it != solvers.end() ? it->second.get() : nullptr;
+            }
+
+            /**
+                Returns true if all the call sites of a function are known
+            */
+            bool isTracked(Function *F) const {
+                return trackedFunctions.count(F);
+            }
+
+            LatticeValue getArgumentValue(Argument *arg) const {
+                return argumentValues.lookup(arg);
+            }
+
+            const ReturnValueMap &getReturnValues() const {
+                return returnValues;
+            }
+
+        private:
+            Module &M;
+
+            SmallPtrSet<Function*, 16> solvedFunctions;
+            ReturnValueMap returnValues;
+            SmallPtrSet<Function*, 16> trackedFunctions;
+            DenseMap<Argument*, LatticeValue> argumentValues;
+            DenseMap<Function*, std::unique_ptr<ConstantPropagationSolver>> solvers;
+
+            std::deque<Function*> worklist;
+            SmallPtrSet<Function*, 16> inWorklist;
+            bool resolveUndefined = false;
+
+            void pushFunction(Function *F);
+            void solveFunction(Function &F);
+    };
+}
+
+/**
+    Returns the function a call site calls directly, nullptr for indirect calls
+    and for calls whose type does not match the one of the callee
+*/
+static Function *getDirectCallee(CallBase &call) {
+    Function *callee = call.getCalledFunction();
+
+    if (!callee || callee->getFunctionType() != call.getFunctionType()) return nullptr;
+
+    return callee;
+}
+
+InterproceduralSolver::InterproceduralSolver(Module &M) : M(M) {
+    for (Function &F : M) {
+        if (F.isDeclaration()) continue;
+
+        solvedFunctions.insert(&F);
+
+        // Another definition may replace an interposable one at link time
+        if (F.hasExactDefinition()) returnValues[&F] = LatticeValue();
+    }
+
+    for (Function *F : solvedFunctions) {
+        // The arguments are only known if every call site passes its values to them
+        bool hasOnlyKnownCalls = all_of(F->users(), [this, F](User *U) {
+            CallBase *call = dyn_cast<CallBase>(U);
+
+            return call && getDirectCallee(*call) == F && solvedFunctions.count(call->getFunction());
+        });
+
+        if (F->hasLocalLinkage() && !F->hasAddressTaken() && hasOnlyKnownCalls) trackedFunctions.insert(F);
+    }
+}
+
+void InterproceduralSolver::pushFunction(Function *F) {
+    if (inWorklist.insert(F).second) worklist.push_back(F);
+}
+
+/**
+    Solves a function with the current summaries, then propagates its results:
+    its return value to the callers, its call site arguments to the callees
+*/
+void InterproceduralSolver::solveFunction(Function &F) {
+    auto solver = std::make_unique<ConstantPropagationSolver>(F, &returnValues);
+
+    if (isTracked(&F)) {
+        for (Argument &arg : F.args()) {
+            solver->setArgumentValue(&arg, argumentValues.lookup(&arg));
+        }
+    }
+
+    solver->solve(resolveUndefined);
+
+    auto summary = returnValues.find(&F);
+
+    if (summary != returnValues.end() && summary->second.meet(solver->getReturnValue())) {
+        for (User *U : F.users()) {
+            CallBase *call = dyn_cast<CallBase>(U);
+
+            if (call && getDirectCallee(*call) == &F) pushFunction(call->getFunction());
+        }
+    }
+
+    for (BasicBlock &BB : F) {
+        if (!solver->isExecutable(&BB)) continue;
+
+        for (Instruction &inst : BB) {
+            CallBase *call = dyn_cast<CallBase>(&inst);
+            if (!call) continue;
+
+            Function *callee = getDirectCallee(*call);
+            if (!callee || !isTracked(callee)) continue;
+
+            bool changed = false;
+
+            for (Argument &arg : callee->args()) {
+                if (argumentValues[&arg].meet(solver->getValue(call->getArgOperand(arg.getArgNo())))) changed = true;
+            }
+
+            if (changed) pushFunction(callee);
+        }
+    }
+
+    solvers[&F] = std::move(solver);
+}
+
+/**
+    Iterates until no summary changes, then again with the undefined branches
+    resolved. Every function is solved at least once, even if it is never called,
+    so that all of them get a final result
+*/
+void InterproceduralSolver::solve() {
+    CallGraph CG(M);
+
+    for (bool resolve : {false, true}) {
+        resolveUndefined = resolve;
+
+        // The SCCs of the call graph come out callees first
+        for (scc_iterator<CallGraph*> it = scc_begin(&CG); !it.isAtEnd(); ++it) {
+            for (CallGraphNode *node : *it) {
+                Function *F = node->getFunction();
+
+                if (F && solvedFunctions.count(F)) pushFunction(F);
+            }
+        }
+
+        while (!worklist.empty()) {
+            Function *F = worklist.front();
+            worklist.pop_front();
+            inWorklist.erase(F);
+
+            solveFunction(*F);
+        }
+    }
+}
+
+/**
+    Returns the number of instructions of a function
+*/
+static unsigned getFunctionSize(Function &F) {
+    unsigned size = 0;
+
+    for (BasicBlock &BB : F) {
+        size += BB.size();
+    }
+
+    return size;
+}
+
+/**
+    Returns true if binding the arguments of a function to the constants of a group
+    of call sites folds something the propagation could not fold in the function
+    itself: a block becomes unreachable, or an instruction other than a load (which
+    only forwards the argument) becomes constant
+*/
+static bool enablesFolding(Function &F, ArrayRef<Constant*> constants, const InterproceduralSolver &solver) {
+    const ConstantPropagationSolver *original = solver.getSolver(&F);
+    ConstantPropagationSolver specialized(F, &solver.getReturnValues());
+
+    for (Argument &arg : F.args()) {
+        if (Constant *C = constants[arg.getArgNo()]) specialized.setArgumentValue(&arg, LatticeValue::get(C));
+        else if (solver.isTracked(&F)) specialized.setArgumentValue(&arg, solver.getArgumentValue(&arg));
+    }
+
+    specialized.solve();
+
+    for (BasicBlock &BB : F) {
+        if (!original->isExecutable(&BB)) continue;
+        if (!specialized.isExecutable(&BB)) return true;
+
+        for (Instruction &inst : BB) {
+            if (isa<LoadInst>(inst)) continue;
+
+            if (specialized.getConstant(&inst) && !original->getConstant(&inst)) return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+    Clones the functions called with constant arguments that the propagation could
+    not bind to the arguments themselves: the functions that can be called from
+    outside the module, and the ones called with different constants from different
+    call sites.
+
+    The executable call sites of a function are grouped by the constants they pass
+    to the arguments that are used, and every group gets its own internal copy of
+    the function, with those arguments replaced by the constants. The copies keep
+    the signature of the original, so the calls only change their callee.
+
+    The groups with the most call sites are cloned first, and only if the constants
+    fold something in the function, up to -ipcp-specialize-max-clones copies per
+    function and -ipcp-specialize-budget instructions over the whole module.
+
+    The internal originals whose call sites were all redirected to their copies are
+    added to deadFunctions, to be erased by the caller once the solver, whose maps
+    still refer to them, is gone.
+
+    Returns true if a function was specialized
+*/
+static bool specializeFunctions(Module &M, const InterproceduralSolver &solver, SmallVectorImpl<Function*> &deadFunctions) {
+    using CallSiteGroup = std::pair<SmallVector<Constant*, 4>, SmallVector<CallBase*, 4>>;
+
+    bool specialized = false;
+    unsigned budget = SpecializationBudget;
+    SmallVector<Function*, 16> functions;
+
+    for (Function &F : M) {
+        if (
+            solver.getSolver(&F) && F.hasExactDefinition() && !F.isVarArg() &&
+            getFunctionSize(F) <= SpecializationMaxSize
+        ) {
+            functions.push_back(&F);
+        }
+    }
+
+    for (Function *F : functions) {
+        SmallVector<CallSiteGroup, 4> groups;
+
+        // The copy of a recursive function would still call the original
+        bool isRecursive = any_of(F->users(), [F](User *U) {
+            Instruction *inst = dyn_cast<Instruction>(U);
+
+            return inst && inst->getFunction() == F;
+        });
+
+        if (isRecursive) continue;
+
+        for (User *U : F->users()) {
+            CallBase *call = dyn_cast<CallBase>(U);
+            if (!call || getDirectCallee(*call) != F || is_contained(deadFunctions, call->getFunction())) continue;
+
+            const ConstantPropagationSolver *callerSolver = solver.getSolver(call->getFunction());
+            if (!callerSolver || !callerSolver->isExecutable(call->getParent())) continue;
+
+            SmallVector<Constant*, 4> constants(F->arg_size(), nullptr);
+            bool hasConstants = false;
+
+            for (Argument &arg : F->args()) {
+                Constant *C = callerSolver->getConstant(call->getArgOperand(arg.getArgNo()));
+
+                // Nothing to gain if the argument is unused or already bound to the constant
+                if (!C || arg.use_empty() || (solver.isTracked(F) && solver.getArgumentValue(&arg).isConstant())) continue;
+
+                constants[arg.getArgNo()] = C;
+                hasConstants = true;
+            }
+
+            if (!hasConstants) continue;
+
+            auto group = find_if(groups, [&constants](const CallSiteGroup &g) { return g.first == constants; });
+
+            if (group != groups.end()) group->second.push_back(call);
+            else groups.push_back({constants, {call}});
+        }
+
+        unsigned size = getFunctionSize(*F);
+        unsigned clones = 0;
+
+        llvm::stable_sort(groups, [](const CallSiteGroup &a, const CallSiteGroup &b) {
+            return a.second.size() > b.second.size();
+        });
+
+        for (CallSiteGroup &group : groups) {
+            if (clones == SpecializationMaxClones || size > budget) break;
+            if (!enablesFolding(*F, group.first, solver)) continue;
+
+            clones++;
+            budget -= size;
+
+            ValueToValueMapTy VMap;
+            Function *clone = CloneFunction(F, VMap);
+
+            clone->setName(F->getName() + ".specialized");
+            clone->setLinkage(GlobalValue::InternalLinkage);
+            clone->setVisibility(GlobalValue::DefaultVisibility);
+            clone->setComdat(nullptr);
+
+            for (Argument &arg : clone->args()) {
+                if (Constant *C = group.first[arg.getArgNo()]) arg.replaceAllUsesWith(C);
+            }
+
+            for (CallBase *call : group.second) {
+                call->setCalledFunction(clone);
+            }
+
+            specialized = true;
+        }
+
+        // An internal function whose call sites were all redirected to the copies
+        if (clones && F->hasLocalLinkage() && F->use_empty()) deadFunctions.push_back(F);
+    }
+
+    return specialized;
+}
+
+PreservedAnalyses InterproceduralConstantPropagation::run(Module &M, ModuleAnalysisManager &AM) {
+    bool transformed = false;
+    auto solver = std::make_unique<InterproceduralSolver>(M);
+    solver->solve();
+
+    SmallVector<Function*, 4> deadFunctions;
+
+    // The copies are solved again with the rest of the module, their arguments
+    // now known from the call sites redirected to them
+    if (SpecializeFunctions && specializeFunctions(M, *solver, deadFunctions)) {
+        transformed = true;
+
+        solver.reset();
+
+        for (Function *F : deadFunctions) {
+            F->eraseFromParent();
+        }
+
+        solver = std::make_unique<InterproceduralSolver>(M);
+        solver->solve();
+    }
+
+    for (Function &F : M) {
+        const ConstantPropagationSolver *functionSolver = solver->getSolver(&F);
+
+        if (functionSolver && transformFunction(F, *functionSolver)) transformed = true;
+    }
+
+    if (transformed) return PreservedAnalyses::none();
+
+    return PreservedAnalyses::all();
+}
@@ -0,0 +1,25 @@
+#include <cstdlib>
+#include <iostream>
+
+int main() {
+    int data[16];
+    int sum = 0;
+
+    for (int i = 0; i < 16; i++) {
+        data[i] = i * 3;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        // Bounds check of the safe array: i is in [0, 15] inside the loop, so it never fails
+        if (i < 0 || i >= 16) std::abort();
+
+        // i + 1 is in [1, 16]: this check can fail and is kept
+        if (i + 1 >= 16) break;
+
+        sum += data[i];
+    }
+
+    std::cout << sum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+; ModuleID = 'bounds_check_example.cpp'
+source_filename = "bounds_check_example.cpp"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-i128:128-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+module asm ".globl _ZSt21ios_base_library_initv"
+
+%"class.std::basic_ostream" = type { ptr, %"class.std::basic_ios" }
+%"class.std::basic_ios" = type { %"class.std::ios_base", ptr, i8, i8, ptr, ptr, ptr, ptr }
+%"class.std::ios_base" = type { ptr, i64, i64, i32, i32, i32, ptr, %"struct.std::ios_base::_Words", [8 x %"struct.std::ios_base::_Words"], i32, ptr, %"class.std::locale" }
+%"struct.std::ios_base::_Words" = type { ptr, i64 }
+%"class.std::locale" = type { ptr }
+
+@_ZSt4cout = external global %"class.std::basic_ostream", align 8
+
+; Function Attrs: mustprogress noinline norecurse uwtable
+define dso_local noundef i32 @main() #0 {
+  %1 = alloca i32, align 4
+  %2 = alloca [16 x i32], align 16
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  store i32 0, ptr %1, align 4
+  store i32 0, ptr %3, align 4
+  store i32 0, ptr %4, align 4
+  br label %6
+
+6:                                                ; preds = %15, %0
+  %7 = load i32, ptr %4, align 4
+  %8 = icmp slt i32 %7, 16
+  br i1 %8, label %9, label %18
+
+9:                                                ; preds = %6
+  %10 = load i32, ptr %4, align 4
+  %11 = mul nsw i32 %10, 3
+  %12 = load i32, ptr %4, align 4
+  %13 = sext i32 %12 to i64
+  %14 = getelementptr inbounds [16 x i32], ptr %2, i64 0, i64 %13
+  store i32 %11, ptr %14, align 4
+  br label %15
+
+15:                                               ; preds = %9
+  %16 = load i32, ptr %4, align 4
+  %17 = add nsw i32 %16, 1
+  store i32 %17, ptr %4, align 4
+  br label %6, !llvm.loop !6
+
+18:                                               ; preds = %6
+  store i32 0, ptr %5, align 4
+  br label %19
+
+19:                                               ; preds = %40, %18
+  %20 = load i32, ptr %5, align 4
+  %21 = icmp slt i32 %20, 16
+  br i1 %21, label %22, label %44
+
+22:                                               ; preds = %19
+  %23 = load i32, ptr %5, align 4
+  %24 = icmp slt i32 %23, 0
+  br i1 %24, label %28, label %25
+
+25:                                               ; preds = %22
+  %26 = load i32, ptr %5, align 4
+  %27 = icmp sge i32 %26, 16
+  br i1 %27, label %28, label %29
+
+28:                                               ; preds = %25, %22
+  call void @abort() #3
+  unreachable
+
+29:                                               ; preds = %25
+  %30 = load i32, ptr %5, align 4
+  %31 = add nsw i32 %30, 1
+  %32 = icmp sge i32 %31, 16
+  br i1 %32, label %33, label %34
+
+33:                                               ; preds = %29
+  br label %44
+
+34:                                               ; preds = %29
+  %35 = load i32, ptr %5, align 4
+  %36 = sext i32 %35 to i64
+  %37 = getelementptr inbounds [16 x i32], ptr %2, i64 0, i64 %36
+  %38 = load i32, ptr %37, align 4
+  %39 = load i32, ptr %3, align 4
+  %40 = add nsw i32 %39, %38
+  store i32 %40, ptr %3, align 4
+  br label %41
+
+41:                                               ; preds = %34
+  %42 = load i32, ptr %5, align 4
+  %43 = add nsw i32 %42, 1
+  store i32 %43, ptr %5, align 4
+  br label %19, !llvm.loop !8
+
+44:                                               ; preds = %33, %19
+  %45 = load i32, ptr %3, align 4
+  %46 = call noundef nonnull align 8 dereferenceable(8) ptr @_ZNSolsEi(ptr noundef nonnull align 8 dereferenceable(8) @_ZSt4cout, i32 noundef %45)
+  %47 = call noundef nonnull align 8 dereferenceable(8) ptr @_ZNSolsEPFRSoS_E(ptr noundef nonnull align 8 dereferenceable(8) %46, ptr noundef @_ZSt4endlIcSt11char_traitsIcEERSt13basic_ostreamIT_T0_ES6_)
+  ret i32 0
+}
+
+; Function Attrs: noreturn nounwind
+declare void @abort() #1
+
+declare noundef nonnull align 8 dereferenceable(8) ptr @_ZNSolsEi(ptr noundef nonnull align 8 dereferenceable(8), i32 noundef) #2
+
+declare noundef nonnull align 8 dereferenceable(8) ptr @_ZNSolsEPFRSoS_E(ptr noundef nonnull align 8 dereferenceable(8), ptr noundef) #2
+
+declare noundef nonnull align 8 dereferenceable(8) ptr @_ZSt4endlIcSt11char_traitsIcEERSt13basic_ostreamIT_T0_ES6_(ptr noundef nonnull align 8 dereferenceable(8)) #2
+
+attributes #0 = { mustprogress noinline norecurse uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cmov,+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { noreturn nounwind "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cmov,+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #2 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cmov,+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #3 = { noreturn nounwind }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 8, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 19.1.7 (++20250114103320+cd708029e0b2-1~exp1~20250114103432.75)"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
+!8 = distinct !{!8, !7}
@@ -0,0 +1,49 @@
+#include <iostream>
+
+// Always called with the same constant: the argument is bound to the function itself
+static int square(int x) {
+    return x * x;
+}
+
+// Called with different factors: x is bound, the factor needs a specialized copy per call
+static int scale(int x, int factor) {
+    return x * factor;
+}
+
+// Visible outside the module: the mode can only be bound to a specialized copy
+int clamp(int value, int mode) {
+    if (mode == 0) return value;
+    if (value > 10) return 10;
+    return value;
+}
+
+// Recursive: the return value is found through the summary of the function itself
+static int countdown(int n) {
+    if (n <= 0) return 0;
+    return countdown(n - 1);
+}
+
+// Only called by halfOfTen: the argument is bound by its call site
+static int half(int x) {
+    if (x > 0) return x / 2;
+    return 0;
+}
+
+// Inline, so linkonce_odr: another copy may be kept at link time, so its result
+// is not given to the callers, but its call still binds the argument of half
+inline int halfOfTen() {
+    return half(10);
+}
+
+int main() {
+    int a = square(3);      // a = 9
+    int b = scale(a, 2);    // b = 18 with the specialization
+    int c = scale(a, 3);    // c = 27 with the specialization
+    int d = clamp(b, 0);    // d = 18 with the specialization
+    int e = countdown(5);   // e = 0
+    int f = halfOfTen();    // f = 5, not folded in main
+
+    std::cout << a + b + c + d + e + f << std::endl;
+
+    return 0;
+}
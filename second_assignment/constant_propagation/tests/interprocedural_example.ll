@@ -0,0 +1,190 @@
+; ModuleID = 'interprocedural_example.cpp'
+source_filename = "interprocedural_example.cpp"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-i128:128-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+module asm ".globl _ZSt21ios_base_library_initv"
+
+%"class.std::basic_ostream" = type { ptr, %"class.std::basic_ios" }
+%"class.std::basic_ios" = type { %"class.std::ios_base", ptr, i8, i8, ptr, ptr, ptr, ptr }
+%"class.std::ios_base" = type { ptr, i64, i64, i32, i32, i32, ptr, %"struct.std::ios_base::_Words", [8 x %"struct.std::ios_base::_Words"], i32, ptr, %"class.std::locale" }
+%"struct.std::ios_base::_Words" = type { ptr, i64 }
+%"class.std::locale" = type { ptr }
+
+$_Z9halfOfTenv = comdat any
+
+@_ZSt4cout = external global %"class.std::basic_ostream", align 8
+
+; Function Attrs: mustprogress noinline nounwind uwtable
+define dso_local noundef i32 @_Z5clampii(i32 noundef %0, i32 noundef %1) #0 {
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  store i32 %0, ptr %4, align 4
+  store i32 %1, ptr %5, align 4
+  %6 = load i32, ptr %5, align 4
+  %7 = icmp eq i32 %6, 0
+  br i1 %7, label %8, label %10
+
+8:                                                ; preds = %2
+  %9 = load i32, ptr %4, align 4
+  store i32 %9, ptr %3, align 4
+  br label %16
+
+10:                                               ; preds = %2
+  %11 = load i32, ptr %4, align 4
+  %12 = icmp sgt i32 %11, 10
+  br i1 %12, label %13, label %14
+
+13:                                               ; preds = %10
+  store i32 10, ptr %3, align 4
+  br label %16
+
+14:                                               ; preds = %10
+  %15 = load i32, ptr %4, align 4
+  store i32 %15, ptr %3, align 4
+  br label %16
+
+16:                                               ; preds = %14, %13, %8
+  %17 = load i32, ptr %3, align 4
+  ret i32 %17
+}
+
+; Function Attrs: mustprogress noinline norecurse uwtable
+define dso_local noundef i32 @main() #1 {
+  %1 = alloca i32, align 4
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  %6 = alloca i32, align 4
+  %7 = alloca i32, align 4
+  store i32 0, ptr %1, align 4
+  %8 = call noundef i32 @_ZL6squarei(i32 noundef 3)
+  store i32 %8, ptr %2, align 4
+  %9 = load i32, ptr %2, align 4
+  %10 = call noundef i32 @_ZL5scaleii(i32 noundef %9, i32 noundef 2)
+  store i32 %10, ptr %3, align 4
+  %11 = load i32, ptr %2, align 4
+  %12 = call noundef i32 @_ZL5scaleii(i32 noundef %11, i32 noundef 3)
+  store i32 %12, ptr %4, align 4
+  %13 = load i32, ptr %3, align 4
+  %14 = call noundef i32 @_Z5clampii(i32 noundef %13, i32 noundef 0)
+  store i32 %14, ptr %5, align 4
+  %15 = call noundef i32 @_ZL9countdowni(i32 noundef 5)
+  store i32 %15, ptr %6, align 4
+  %16 = call noundef i32 @_Z9halfOfTenv()
+  store i32 %16, ptr %7, align 4
+  %17 = load i32, ptr %2, align 4
+  %18 = load i32, ptr %3, align 4
+  %19 = add nsw i32 %17, %18
+  %20 = load i32, ptr %4, align 4
+  %21 = add nsw i32 %19, %20
+  %22 = load i32, ptr %5, align 4
+  %23 = add nsw i32 %21, %22
+  %24 = load i32, ptr %6, align 4
+  %25 = add nsw i32 %23, %24
+  %26 = load i32, ptr %7, align 4
+  %27 = add nsw i32 %25, %26
+  %28 = call noundef nonnull align 8 dereferenceable(8) ptr @_ZNSolsEi(ptr noundef nonnull align 8 dereferenceable(8) @_ZSt4cout, i32 noundef %27)
+  %29 = call noundef nonnull align 8 dereferenceable(8) ptr @_ZNSolsEPFRSoS_E(ptr noundef nonnull align 8 dereferenceable(8) %28, ptr noundef @_ZSt4endlIcSt11char_traitsIcEERSt13basic_ostreamIT_T0_ES6_)
+  ret i32 0
+}
+
+; Function Attrs: mustprogress noinline nounwind uwtable
+define internal noundef i32 @_ZL6squarei(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  %3 = load i32, ptr %2, align 4
+  %4 = load i32, ptr %2, align 4
+  %5 = mul nsw i32 %3, %4
+  ret i32 %5
+}
+
+; Function Attrs: mustprogress noinline nounwind uwtable
+define internal noundef i32 @_ZL5scaleii(i32 noundef %0, i32 noundef %1) #0 {
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  store i32 %0, ptr %3, align 4
+  store i32 %1, ptr %4, align 4
+  %5 = load i32, ptr %3, align 4
+  %6 = load i32, ptr %4, align 4
+  %7 = mul nsw i32 %5, %6
+  ret i32 %7
+}
+
+; Function Attrs: mustprogress noinline uwtable
+define internal noundef i32 @_ZL9countdowni(i32 noundef %0) #2 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  store i32 %0, ptr %3, align 4
+  %4 = load i32, ptr %3, align 4
+  %5 = icmp sle i32 %4, 0
+  br i1 %5, label %6, label %7
+
+6:                                                ; preds = %1
+  store i32 0, ptr %2, align 4
+  br label %11
+
+7:                                                ; preds = %1
+  %8 = load i32, ptr %3, align 4
+  %9 = sub nsw i32 %8, 1
+  %10 = call noundef i32 @_ZL9countdowni(i32 noundef %9)
+  store i32 %10, ptr %2, align 4
+  br label %11
+
+11:                                               ; preds = %7, %6
+  %12 = load i32, ptr %2, align 4
+  ret i32 %12
+}
+
+; Function Attrs: mustprogress noinline uwtable
+define linkonce_odr dso_local noundef i32 @_Z9halfOfTenv() #2 comdat {
+  %1 = call noundef i32 @_ZL4halfi(i32 noundef 10)
+  ret i32 %1
+}
+
+; Function Attrs: mustprogress noinline nounwind uwtable
+define internal noundef i32 @_ZL4halfi(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  store i32 %0, ptr %3, align 4
+  %4 = load i32, ptr %3, align 4
+  %5 = icmp sgt i32 %4, 0
+  br i1 %5, label %6, label %9
+
+6:                                                ; preds = %1
+  %7 = load i32, ptr %3, align 4
+  %8 = sdiv i32 %7, 2
+  store i32 %8, ptr %2, align 4
+  br label %10
+
+9:                                                ; preds = %1
+  store i32 0, ptr %2, align 4
+  br label %10
+
+10:                                               ; preds = %9, %6
+  %11 = load i32, ptr %2, align 4
+  ret i32 %11
+}
+
+declare noundef nonnull align 8 dereferenceable(8) ptr @_ZNSolsEi(ptr noundef nonnull align 8 dereferenceable(8), i32 noundef) #3
+
+declare noundef nonnull align 8 dereferenceable(8) ptr @_ZNSolsEPFRSoS_E(ptr noundef nonnull align 8 dereferenceable(8), ptr noundef) #3
+
+declare noundef nonnull align 8 dereferenceable(8) ptr @_ZSt4endlIcSt11char_traitsIcEERSt13basic_ostreamIT_T0_ES6_(ptr noundef nonnull align 8 dereferenceable(8)) #3
+
+attributes #0 = { mustprogress noinline nounwind uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cmov,+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { mustprogress noinline norecurse uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cmov,+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #2 = { mustprogress noinline uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cmov,+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #3 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cmov,+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 8, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 19.1.7 (++20250114103320+cd708029e0b2-1~exp1~20250114103432.75)"}
@@ -0,0 +1,40 @@
+; ModuleID = 'stale_refinement_example.ll'
+; Written by hand: the comparison of %v is in a different block from the branch
+; that uses it, which the unoptimized code of clang never does. The narrowing of
+; %v on the edge %b -> %t must follow the growth of %v in the loop, otherwise %v2
+; stays 1, %c2 looks always true and the exit of the loop is removed.
+;
+; The function returns 0 after 100 iterations.
+source_filename = "stale_refinement_example.ll"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-i128:128-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+define dso_local noundef i32 @main() {
+entry:
+  br label %header
+
+header:                                           ; preds = %latch, %entry
+  %v = phi i32 [ 0, %entry ], [ %v2, %latch ]
+  br label %a
+
+a:                                                ; preds = %header
+  %cmp = icmp ult i32 %v, 3
+  br label %b
+
+b:                                                ; preds = %a
+  br i1 %cmp, label %t, label %fb
+
+t:                                                ; preds = %b
+  br label %latch
+
+fb:                                               ; preds = %b
+  br label %latch
+
+latch:                                            ; preds = %fb, %t
+  %v2 = add i32 %v, 1
+  %c2 = icmp ult i32 %v2, 100
+  br i1 %c2, label %header, label %exit
+
+exit:                                             ; preds = %latch
+  ret i32 0
+}
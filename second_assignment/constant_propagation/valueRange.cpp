@@ -0,0 +1,655 @@
+#include "valueRange.hpp"
+#include "constantPropagation.hpp"
+
+#include "llvm/Analysis/CFG.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Operator.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "value-range"
+
+STATISTIC(NumBlockVisits, "Number of basic block visits of the value-range analysis");
+
+/**
+    Number of visits of a loop header before its input is widened: the first ones
+    let short loops be computed exactly
+*/
+static constexpr unsigned WideningDelay = 3;
+
+/**
+    Number of visits of any block before its input is widened, so that the cycles
+    of irreducible control flow, which have no single header, terminate as well
+*/
+static constexpr unsigned MaxVisits = 16;
+
+/**
+    Number of passes over the function after the widened fixed point is reached
+*/
+static constexpr unsigned NarrowingPasses = 2;
+
+void RangeState::meet(const RangeState &other) {
+    for (unsigned i = 0; i < variables.size(); i++) {
+        variables[i] = variables[i].unionWith(other.variables[i]);
+    }
+
+    for (auto it = refinements.begin(); it != refinements.end();) {
+        auto otherIt = other.refinements.find(it->first);
+
+        if (otherIt == other.refinements.end()) {
+            it = refinements.erase(it);
+        } else {
+            it->second = it->second.unionWith(otherIt->second);
+            ++it;
+        }
+    }
+}
+
+/**
+    Widening operator on the signed view of the ranges: a bound that keeps growing
+    jumps to the closest threshold, the constants the function compares its values
+    with (a loop counter stops at its bound instead of the maximum value), or to the
+    minimum or maximum value if there is none. Every bound can only take a finite
+    number of values, so the widened ranges stop changing
+*/
+static ConstantRange widen(const ConstantRange &previous, const ConstantRange &next, ArrayRef<APInt> thresholds) {
+    if (previous.isEmptySet()) return next;
+    if (previous.contains(next)) return previous;
+
+    unsigned width = previous.getBitWidth();
+    APInt lower = previous.getSignedMin();
+    APInt upper = previous.getSignedMax();
+
+    if (next.getSignedMin().slt(lower)) {
+        lower = APInt::getSignedMinValue(width);
+
+        for (const APInt &threshold : thresholds) {
+            if (threshold.getBitWidth() == width && threshold.sle(next.getSignedMin()) && threshold.sgt(lower)) {
+                lower = threshold;
+            }
+        }
+    }
+
+    if (next.getSignedMax().sgt(upper)) {
+        upper = APInt::getSignedMaxValue(width);
+
+        for (const APInt &threshold : thresholds) {
+            if (threshold.getBitWidth() == width && threshold.sge(next.getSignedMax()) && threshold.slt(upper)) {
+                upper = threshold;
+            }
+        }
+    }
+
+    return ConstantRange::getNonEmpty(lower, upper + 1);
+}
+
+static void widen(const RangeState &previous, RangeState &next, ArrayRef<APInt> thresholds) {
+    for (unsigned i = 0; i < next.variables.size(); i++) {
+        next.variables[i] = widen(previous.variables[i], next.variables[i], thresholds);
+    }
+
+    // A refinement the previous state did not have is dropped, so that the set of
+    // refinements can only shrink as well
+    for (auto it = next.refinements.begin(); it != next.refinements.end();) {
+        auto previousIt = previous.refinements.find(it->first);
+
+        if (previousIt == previous.refinements.end()) {
+            it = next.refinements.erase(it);
+        } else {
+            it->second = widen(previousIt->second, it->second, thresholds);
+            ++it;
+        }
+    }
+}
+
+ValueRangeSolver::ValueRangeSolver(Function &F) : F(F), worklist(F, DataflowDirection::Forward) {
+    for (Instruction &inst : instructions(F)) {
+        AllocaInst *AI = dyn_cast<AllocaInst>(&inst);
+
+        if (AI && AI->getAllocatedType()->isIntegerTy() && isAllocaPromotable(AI)) {
+            variableIndex[AI] = variables.size();
+            variables.push_back(AI);
+        }
+
+        // The bound of i < n is reached by i, the one of i <= n is exceeded by one
+        ICmpInst *cmp = dyn_cast<ICmpInst>(&inst);
+        if (!cmp) continue;
+
+        for (Value *op : cmp->operands()) {
+            ConstantInt *C = dyn_cast<ConstantInt>(op);
+            if (!C) continue;
+
+            thresholds.push_back(C->getValue() - 1);
+            thresholds.push_back(C->getValue());
+            thresholds.push_back(C->getValue() + 1);
+        }
+    }
+}
+
+ConstantRange ValueRangeSolver::getRange(Value *V) const {
+    unsigned width = V->getType()->getIntegerBitWidth();
+
+    if (ConstantInt *CI = dyn_cast<ConstantInt>(V)) return ConstantRange(CI->getValue());
+
+    if (isa<Instruction>(V)) {
+        auto it = values.find(V);
+
+        return it != values.end() ? it->second : ConstantRange::getEmpty(width);
+    }
+
+    // Arguments, undef and the other constants
+    return ConstantRange::getFull(width);
+}
+
+/**
+    Returns the range of an integer value at a program point, narrowed by the
+    branches taken to get there
+*/
+ConstantRange ValueRangeSolver::getRange(Value *V, const RangeState &state) const {
+    auto it = state.refinements.find(V);
+
+    return it != state.refinements.end() ? it->second : getRange(V);
+}
+
+Constant *ValueRangeSolver::getConstant(Value *V) const {
+    if (!V->getType()->isIntegerTy()) return nullptr;
+
+    const APInt *C = getRange(V).getSingleElement();
+
+    return C ? ConstantInt::get(V->getType(), *C) : nullptr;
+}
+
+void ValueRangeSolver::pushBlock(BasicBlock *BB) {
+    worklist.push(BB);
+}
+
+/**
+    Sets the state of a feasible edge, enqueueing its destination if it changed.
+
+    The state of an edge depends both on the state at the end of the block it leaves
+    and on the ranges of the operands of the comparison, so it can change even if
+    the block state does not
+*/
+void ValueRangeSolver::updateEdge(BasicBlock *from, BasicBlock *to, RangeState edge) {
+    // The narrowing passes only shrink the ranges, they never make an edge feasible
+    if (narrowing && !isEdgeFeasible(from, to)) return;
+
+    if (feasibleEdges.insert({from, to}).second) executableBlocks.insert(to);
+
+    auto it = edgeStates.find({from, to});
+
+    if (it == edgeStates.end()) {
+        edgeStates.insert({{from, to}, std::move(edge)});
+    } else if (it->second != edge) {
+        it->second = std::move(edge);
+    } else {
+        return;
+    }
+
+    if (!narrowing) pushBlock(to);
+}
+
+/**
+    Sets the range of an instruction, enqueueing the blocks of its users if it changed.
+    The blocks that branch on a comparison using it are enqueued as well, even when
+    the comparison is in another block and its result did not change, since the
+    states of their edges narrow the new range.
+
+    Ranges are recomputed from scratch at every visit: the inputs of the blocks only
+    grow while the fixed point is searched, and only shrink while narrowing
+*/
+void ValueRangeSolver::setRange(Instruction &inst, const ConstantRange &R) {
+    auto it = values.find(&inst);
+
+    if (it != values.end()) {
+        if (it->second == R) return;
+        it->second = R;
+    } else {
+        values.insert({&inst, R});
+    }
+
+    if (narrowing) return;
+
+    for (User *U : inst.users()) {
+        BasicBlock *BB = cast<Instruction>(U)->getParent();
+
+        if (isExecutable(BB)) pushBlock(BB);
+        if (!isa<ICmpInst>(U)) continue;
+
+        for (User *branch : U->users()) {
+            BasicBlock *branchBB = cast<Instruction>(branch)->getParent();
+
+            if (isa<BranchInst>(branch) && branchBB != BB && isExecutable(branchBB)) pushBlock(branchBB);
+        }
+    }
+}
+
+/**
+    Narrows the range of a value to the allowed one, on the edge leaving a block.
+    If the value is a load of a tracked variable in that block, and the variable
+    is not stored again before the branch, the variable is narrowed as well.
+
+    Returns false if the value cannot be in the allowed range, i.e. the edge can
+    never be taken
+*/
+bool ValueRangeSolver::refine(Value *V, const ConstantRange &allowed, BasicBlock *BB, RangeState &state) const {
+    ConstantRange R = getRange(V, state).intersectWith(allowed);
+
+    if (R.isEmptySet()) return false;
+    if (isa<Constant>(V)) return true;
+
+    // A value only used by the comparison, like the loads of the unoptimized code,
+    // is not needed past the branch
+    if (!isa<Instruction>(V) || cast<Instruction>(V)->isUsedOutsideOfBlock(BB)) state.refinements.insert_or_assign(V, R);
+
+    LoadInst *LI = dyn_cast<LoadInst>(V);
+    if (!LI || LI->getParent() != BB) return true;
+
+    auto it = variableIndex.find(LI->getPointerOperand());
+    if (it == variableIndex.end()) return true;
+
+    for (Instruction *inst = LI->getNextNode(); inst; inst = inst->getNextNode()) {
+        StoreInst *SI = dyn_cast<StoreInst>(inst);
+
+        if (SI && SI->getPointerOperand() == LI->getPointerOperand()) return true;
+    }
+
+    ConstantRange &variable = state.variables[it->second];
+    variable = variable.intersectWith(R);
+
+    return !variable.isEmptySet();
+}
+
+/**
+    Computes the state on an edge: the state at the end of the block it leaves,
+    with the operands of the comparison the branch depends on narrowed to the
+    ranges that make it take the edge.
+
+    Returns false if the edge can never be taken
+*/
+bool ValueRangeSolver::computeEdgeState(BasicBlock *from, BasicBlock *to, RangeState &state) const {
+    BranchInst *BI = dyn_cast<BranchInst>(from->getTerminator());
+    if (!BI || !BI->isConditional() || BI->getSuccessor(0) == BI->getSuccessor(1)) return true;
+
+    ICmpInst *cmp = dyn_cast<ICmpInst>(BI->getCondition());
+    if (!cmp || !cmp->getOperand(0)->getType()->isIntegerTy()) return true;
+
+    CmpInst::Predicate pred = BI->getSuccessor(0) == to ? cmp->getPredicate() : cmp->getInversePredicate();
+    Value *LHS = cmp->getOperand(0);
+    Value *RHS = cmp->getOperand(1);
+
+    if (!refine(LHS, ConstantRange::makeAllowedICmpRegion(pred, getRange(RHS, state)), from, state)) return false;
+
+    return refine(RHS, ConstantRange::makeAllowedICmpRegion(CmpInst::getSwappedPredicate(pred), getRange(LHS, state)), from, state);
+}
+
+/**
+    Visits a block with the meet of the states of its feasible incoming edges.
+
+    The input of a loop header is widened with the one of its previous visit,
+    except while narrowing, where every block takes the input computed from its
+    predecessors
+*/
+void ValueRangeSolver::visitBlock(BasicBlock &BB) {
+    SmallVector<std::pair<BasicBlock*, RangeState>, 4> incoming;
+    SmallPtrSet<BasicBlock*, 4> visitedPreds;
+
+    for (BasicBlock *pred : predecessors(&BB)) {
+        if (!visitedPreds.insert(pred).second) continue;
+
+        auto it = edgeStates.find({pred, &BB});
+        if (it != edgeStates.end()) incoming.push_back({pred, it->second});
+    }
+
+    RangeState state;
+
+    if (&BB == &F.getEntryBlock()) {
+        for (AllocaInst *AI : variables) {
+            state.variables.push_back(ConstantRange::getFull(AI->getAllocatedType()->getIntegerBitWidth()));
+        }
+    } else if (incoming.empty()) {
+        return;
+    } else {
+        state = incoming[0].second;
+
+        for (unsigned i = 1; i < incoming.size(); i++) {
+            state.meet(incoming[i].second);
+        }
+
+        // After a join, the refinements of the two sides of a branch usually add up
+        // to the range of the value, and carrying them along would only cost time
+        for (auto it = state.refinements.begin(); it != state.refinements.end();) {
+            if (it->second.contains(getRange(it->first))) it = state.refinements.erase(it);
+            else ++it;
+        }
+    }
+
+    // PHIs take the value of each incoming edge in the state of that edge
+    SmallVector<std::pair<PHINode*, ConstantRange>, 4> phis;
+
+    for (PHINode &phi : BB.phis()) {
+        if (!phi.getType()->isIntegerTy()) continue;
+
+        ConstantRange R = ConstantRange::getEmpty(phi.getType()->getIntegerBitWidth());
+
+        for (auto &[pred, edge] : incoming) {
+            R = R.unionWith(getRange(phi.getIncomingValueForBlock(pred), edge));
+        }
+
+        phis.push_back({&phi, R});
+    }
+
+    unsigned visits = ++visitCount[&BB];
+    auto previous = blockIn.find(&BB);
+
+    if (
+        !narrowing && previous != blockIn.end() && visits > WideningDelay &&
+        (loopHeaders.count(&BB) || visits > MaxVisits)
+    ) {
+        widen(previous->second, state, thresholds);
+
+        for (auto &[phi, R] : phis) {
+            auto it = values.find(phi);
+            if (it != values.end()) R = widen(it->second, R, thresholds);
+        }
+    }
+
+    blockIn[&BB] = state;
+
+    for (auto &[phi, R] : phis) {
+        setRange(*phi, R);
+        state.refinements.erase(phi);
+    }
+
+    for (Instruction &inst : BB) {
+        if (!isa<PHINode>(inst) && !inst.isTerminator()) visitInstruction(inst, state);
+    }
+
+    visitTerminator(*BB.getTerminator(), state);
+    blockOut[&BB] = std::move(state);
+}
+
+void ValueRangeSolver::visitInstruction(Instruction &inst, RangeState &state) {
+    if (StoreInst *SI = dyn_cast<StoreInst>(&inst)) {
+        auto it = variableIndex.find(SI->getPointerOperand());
+
+        if (it != variableIndex.end()) state.variables[it->second] = getRange(SI->getValueOperand(), state);
+
+        return;
+    }
+
+    if (!inst.getType()->isIntegerTy()) return;
+
+    // A new execution of the instruction makes the narrowing of the previous one obsolete
+    state.refinements.erase(&inst);
+
+    if (LoadInst *LI = dyn_cast<LoadInst>(&inst)) {
+        auto it = variableIndex.find(LI->getPointerOperand());
+
+        if (it != variableIndex.end()) setRange(inst, state.variables[it->second]);
+        else setRange(inst, ConstantRange::getFull(inst.getType()->getIntegerBitWidth()));
+
+        return;
+    }
+
+    setRange(inst, evaluate(inst, state));
+}
+
+/**
+    Computes the range of an integer instruction from the ones of its operands,
+    with the range arithmetic of ConstantRange. The no-wrap flags are taken into
+    account: an add nsw whose result would overflow is poison, so its range does
+    not need to include the wrapped values
+*/
+ConstantRange ValueRangeSolver::evaluate(Instruction &inst, const RangeState &state) const {
+    unsigned width = inst.getType()->getIntegerBitWidth();
+
+    if (BinaryOperator *BO = dyn_cast<BinaryOperator>(&inst)) {
+        ConstantRange LHS = getRange(BO->getOperand(0), state);
+        ConstantRange RHS = getRange(BO->getOperand(1), state);
+
+        if (LHS.isEmptySet() || RHS.isEmptySet()) return ConstantRange::getEmpty(width);
+
+        unsigned opCode = BO->getOpcode();
+
+        if (opCode == Instruction::Add || opCode == Instruction::Sub || opCode == Instruction::Mul) {
+            unsigned noWrapKind = 0;
+
+            if (BO->hasNoSignedWrap()) noWrapKind |= OverflowingBinaryOperator::NoSignedWrap;
+            if (BO->hasNoUnsignedWrap()) noWrapKind |= OverflowingBinaryOperator::NoUnsignedWrap;
+
+            if (noWrapKind) return LHS.overflowingBinaryOp(BO->getOpcode(), RHS, noWrapKind);
+        }
+
+        return LHS.binaryOp(BO->getOpcode(), RHS);
+    }
+
+    if (CastInst *CI = dyn_cast<CastInst>(&inst)) {
+        if (!CI->getSrcTy()->isIntegerTy()) return ConstantRange::getFull(width);
+
+        ConstantRange R = getRange(CI->getOperand(0), state);
+        if (R.isEmptySet()) return ConstantRange::getEmpty(width);
+
+        return R.castOp(CI->getOpcode(), width);
+    }
+
+    if (ICmpInst *cmp = dyn_cast<ICmpInst>(&inst)) {
+        if (!cmp->getOperand(0)->getType()->isIntegerTy()) return ConstantRange::getFull(width);
+
+        ConstantRange LHS = getRange(cmp->getOperand(0), state);
+        ConstantRange RHS = getRange(cmp->getOperand(1), state);
+
+        if (LHS.isEmptySet() || RHS.isEmptySet()) return ConstantRange::getEmpty(width);
+
+        if (LHS.icmp(cmp->getPredicate(), RHS)) return ConstantRange(APInt(1, 1));
+        if (LHS.icmp(cmp->getInversePredicate(), RHS)) return ConstantRange(APInt(1, 0));
+
+        return ConstantRange::getFull(width);
+    }
+
+    if (SelectInst *select = dyn_cast<SelectInst>(&inst)) {
+        ConstantRange cond = getRange(select->getCondition(), state);
+        ConstantRange R = ConstantRange::getEmpty(width);
+
+        // The arm that is not selected does not matter
+        if (cond.contains(APInt(1, 1))) R = R.unionWith(getRange(select->getTrueValue(), state));
+        if (cond.contains(APInt(1, 0))) R = R.unionWith(getRange(select->getFalseValue(), state));
+
+        return R;
+    }
+
+    IntrinsicInst *II = dyn_cast<IntrinsicInst>(&inst);
+
+    if (II && ConstantRange::isIntrinsicSupported(II->getIntrinsicID())) {
+        SmallVector<ConstantRange, 2> operands;
+
+        for (Value *arg : II->args()) {
+            if (!arg->getType()->isIntegerTy()) return ConstantRange::getFull(width);
+
+            operands.push_back(getRange(arg, state));
+            if (operands.back().isEmptySet()) return ConstantRange::getEmpty(width);
+        }
+
+        return ConstantRange::intrinsic(II->getIntrinsicID(), operands);
+    }
+
+    return ConstantRange::getFull(width);
+}
+
+/**
+    Updates the outgoing edges the terminator of a block can take: the ones allowed
+    by the range of its condition, if their state is not empty. While narrowing, the
+    edges that can no longer be taken stop contributing to their destination
+*/
+void ValueRangeSolver::visitTerminator(Instruction &inst, const RangeState &state) {
+    BasicBlock *BB = inst.getParent();
+    SmallVector<BasicBlock*, 2> targets;
+
+    if (BranchInst *BI = dyn_cast<BranchInst>(&inst); BI && BI->isConditional()) {
+        ConstantRange cond = getRange(BI->getCondition(), state);
+
+        if (cond.contains(APInt(1, 1))) targets.push_back(BI->getSuccessor(0));
+        if (cond.contains(APInt(1, 0))) targets.push_back(BI->getSuccessor(1));
+    } else if (SwitchInst *SI = dyn_cast<SwitchInst>(&inst)) {
+        ConstantRange cond = getRange(SI->getCondition(), state);
+
+        if (const APInt *C = cond.getSingleElement()) {
+            targets.push_back(SI->findCaseValue(ConstantInt::get(F.getContext(), *C))->getCaseSuccessor());
+        } else if (!cond.isEmptySet()) {
+            targets.append(succ_begin(BB), succ_end(BB));
+        }
+    } else {
+        targets.append(succ_begin(BB), succ_end(BB));
+    }
+
+    for (BasicBlock *succ : successors(BB)) {
+        RangeState edge = state;
+
+        if (is_contained(targets, succ) && computeEdgeState(BB, succ, edge)) updateEdge(BB, succ, std::move(edge));
+        else if (narrowing) edgeStates.erase({BB, succ});
+    }
+}
+
+/**
+    Makes all the edges of the executable terminators feasible if the range of their
+    condition is still empty at the fixed point, like the constant propagation does
+    with the undefined conditions (see ConstantPropagationSolver::resolveUndefinedBranches()),
+    so that the transformation never finds a branch with no feasible edge.
+
+    Returns true if an edge became feasible
+*/
+bool ValueRangeSolver::resolveUndefinedBranches() {
+    bool resolved = false;
+
+    for (BasicBlock &BB : F) {
+        if (!isExecutable(&BB)) continue;
+
+        Instruction *terminator = BB.getTerminator();
+        Value *cond = nullptr;
+
+        if (BranchInst *BI = dyn_cast<BranchInst>(terminator); BI && BI->isConditional()) cond = BI->getCondition();
+        else if (SwitchInst *SI = dyn_cast<SwitchInst>(terminator)) cond = SI->getCondition();
+
+        auto it = blockOut.find(&BB);
+        if (!cond || it == blockOut.end() || !getRange(cond, it->second).isEmptySet()) continue;
+
+        for (BasicBlock *succ : successors(&BB)) {
+            if (isEdgeFeasible(&BB, succ)) continue;
+
+            updateEdge(&BB, succ, it->second);
+            resolved = true;
+        }
+    }
+
+    return resolved;
+}
+
+/**
+    Finds the fixed point with widening at the loop headers (the targets of the
+    back edges of a depth-first search), visiting the blocks in reverse post-order,
+    then narrows it with a few passes in the same order
+*/
+void ValueRangeSolver::solve() {
+    if (F.isDeclaration()) return;
+
+    SmallVector<std::pair<const BasicBlock*, const BasicBlock*>, 8> backEdges;
+    FindFunctionBackedges(F, backEdges);
+
+    for (auto &[from, to] : backEdges) {
+        loopHeaders.insert(const_cast<BasicBlock*>(to));
+    }
+
+    executableBlocks.insert(&F.getEntryBlock());
+    pushBlock(&F.getEntryBlock());
+
+    do {
+        while (!worklist.empty()) {
+            visitBlock(*worklist.pop());
+        }
+    } while (resolveUndefinedBranches());
+
+    NumBlockVisits += worklist.getNumVisits();
+
+    narrowing = true;
+
+    for (unsigned i = 0; i < NarrowingPasses; i++) {
+        for (BasicBlock *BB : worklist.getOrder()) {
+            if (isExecutable(BB)) visitBlock(*BB);
+        }
+    }
+}
+
+AnalysisKey ValueRangeAnalysis::Key;
+
+ValueRangeSolver ValueRangeAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+    ValueRangeSolver solver(F);
+    solver.solve();
+
+    return solver;
+}
+
+PreservedAnalyses ValueRange::run(Module &M, ModuleAnalysisManager &AM) {
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    for (Function &F : M) {
+        if (F.isDeclaration()) continue;
+
+        ValueRangeSolver &solver = FAM.getResult<ValueRangeAnalysis>(F);
+
+        outs() << "Value ranges for function: " << F.getName();
+        outs() << "\n\n";
+
+        for (BasicBlock &BB : F) {
+            if (!solver.isExecutable(&BB)) {
+                outs() << "Unreachable basic block: ";
+                BB.printAsOperand(outs(), false);
+                outs() << "\n\n";
+                continue;
+            }
+
+            outs() << "Value ranges for basic block: ";
+            BB.printAsOperand(outs(), false);
+            outs() << "\n";
+
+            const RangeState &state = solver.getBlockRanges(&BB);
+
+            for (unsigned i = 0; i < state.variables.size(); i++) {
+                if (state.variables[i].isFullSet()) continue;
+
+                solver.getVariables()[i]->print(outs());
+                outs() << ": " << state.variables[i] << "\n";
+            }
+
+            for (Instruction &inst : BB) {
+                if (!isa<ICmpInst>(inst)) continue;
+
+                Constant *C = solver.getConstant(&inst);
+                if (!C) continue;
+
+                inst.print(outs());
+                outs() << ": always " << (C->isOneValue() ? "true" : "false") << "\n";
+            }
+
+            outs() << "\n";
+        }
+
+        outs() << "------------------\n\n";
+    }
+
+    return PreservedAnalyses::all();
+}
+
+PreservedAnalyses ValueRangeTransform::run(Module &M, ModuleAnalysisManager &AM) {
+    bool transformed = false;
+    FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    for (Function &F : M) {
+        if (F.isDeclaration()) continue;
+
+        if (transformFunction(F, FAM.getResult<ValueRangeAnalysis>(F))) transformed = true;
+    }
+
+    if (transformed) return PreservedAnalyses::none();
+
+    return PreservedAnalyses::all();
+}
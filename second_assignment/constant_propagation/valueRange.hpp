@@ -0,0 +1,159 @@
+#ifndef LLVM_TRANSFORMS_VALUERANGE_H
+#define LLVM_TRANSFORMS_VALUERANGE_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Value.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/ConstantRange.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+
+#include "../common/dataflowWorklist.hpp"
+
+#include <map>
+#include <vector>
+
+namespace llvm {
+    /**
+        Ranges known at a program point:
+        - the ones of the tracked variables, indexed by variable number
+        - the ones of the SSA values narrowed by the branches taken to get there,
+          e.g. i < n on the true edge of the comparison
+    */
+    struct RangeState {
+        std::vector<ConstantRange> variables;
+        std::map<Value*, ConstantRange> refinements;
+
+        bool operator==(const RangeState &other) const {
+            return variables == other.variables && refinements == other.refinements;
+        }
+
+        bool operator!=(const RangeState &other) const {
+            return !(*this == other);
+        }
+
+        /**
+            Lowers this state to the meet of itself and other: the union of the ranges,
+            keeping only the refinements both states have
+        */
+        void meet(const RangeState &other);
+    };
+
+    /**
+        Value-range analysis of a function, with the ConstantRange of LLVM as lattice:
+        the empty set is the undefined value (nothing reached it yet), the full set is
+        the overdefined one, and the meet is the union of the ranges.
+
+        Like the constant propagation, the integer variables the unoptimized code keeps
+        in allocas are tracked in memory, and the CFG edges are feasible only when the
+        branch can take them. On top of that, every edge narrows the operands of the
+        comparison it depends on, so the loop counter is known to be below its bound
+        inside the loop.
+
+        Ranges can grow by one element per iteration of a loop, so the input of the loop
+        headers is widened after a few visits (the growing bounds jump to the next constant
+        the function compares with, or to the minimum or maximum value), and a few
+        narrowing passes then recover the bounds implied by the exit conditions.
+    */
+    class ValueRangeSolver {
+        public:
+            explicit ValueRangeSolver(Function &F);
+
+            void solve();
+
+            /**
+                Returns the range of an integer value over all its executions
+            */
+            ConstantRange getRange(Value *V) const;
+
+            /**
+                Returns the constant an integer value was proven to hold, nullptr if its
+                range has more than one element
+            */
+            Constant *getConstant(Value *V) const;
+
+            bool isExecutable(BasicBlock *BB) const {
+                return executableBlocks.count(BB);
+            }
+
+            bool isEdgeFeasible(BasicBlock *from, BasicBlock *to) const {
+                return feasibleEdges.count({from, to});
+            }
+
+            ArrayRef<AllocaInst*> getVariables() const {
+                return variables;
+            }
+
+            /**
+                Returns the ranges at the end of an executable block
+            */
+            const RangeState &getBlockRanges(BasicBlock *BB) const {
+                return blockOut.find(BB)->second;
+            }
+
+        private:
+            Function &F;
+
+            SmallVector<AllocaInst*, 16> variables;
+            DenseMap<Value*, unsigned> variableIndex;
+
+            DenseMap<Value*, ConstantRange> values;
+            SmallPtrSet<BasicBlock*, 32> executableBlocks;
+            DenseSet<std::pair<BasicBlock*, BasicBlock*>> feasibleEdges;
+            DenseMap<std::pair<BasicBlock*, BasicBlock*>, RangeState> edgeStates;
+            DenseMap<BasicBlock*, RangeState> blockIn;
+            DenseMap<BasicBlock*, RangeState> blockOut;
+
+            SmallPtrSet<BasicBlock*, 8> loopHeaders;
+            SmallVector<APInt, 16> thresholds;
+            DenseMap<BasicBlock*, unsigned> visitCount;
+            bool narrowing = false;
+
+            // Blocks to be visited, in reverse post-order, so that the inner blocks
+            // of a loop are stable before its header is widened
+            DataflowWorklist worklist;
+
+            void pushBlock(BasicBlock *BB);
+            void updateEdge(BasicBlock *from, BasicBlock *to, RangeState edge);
+            void setRange(Instruction &inst, const ConstantRange &R);
+
+            ConstantRange getRange(Value *V, const RangeState &state) const;
+
+            bool computeEdgeState(BasicBlock *from, BasicBlock *to, RangeState &state) const;
+            bool refine(Value *V, const ConstantRange &allowed, BasicBlock *BB, RangeState &state) const;
+
+            void visitBlock(BasicBlock &BB);
+            void visitInstruction(Instruction &inst, RangeState &state);
+            void visitTerminator(Instruction &inst, const RangeState &state);
+            bool resolveUndefinedBranches();
+
+            ConstantRange evaluate(Instruction &inst, const RangeState &state) const;
+    };
+
+    class ValueRangeAnalysis : public AnalysisInfoMixin<ValueRangeAnalysis> {
+        friend AnalysisInfoMixin<ValueRangeAnalysis>;
+        static AnalysisKey Key;
+
+        public:
+            using Result = ValueRangeSolver;
+
+            Result run(Function &F, FunctionAnalysisManager &FAM);
+    };
+
+    class ValueRange : public PassInfoMixin<ValueRange> {
+        public:
+            PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+    };
+
+    class ValueRangeTransform : public PassInfoMixin<ValueRangeTransform> {
+        public:
+            PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+    };
+} // namespace llvm
+
+#endif // LLVM_TRANSFORMS_VALUERANGE_H
@@ -2,87 +2,110 @@
 
 using namespace llvm;
 
-bool getBlockDominators(BasicBlock &BB, std::map<BasicBlock*, std::set<BasicBlock*>> &dominators) {
-    std::set<BasicBlock*> blockDoms;
-
-    for (BasicBlock &B : *BB.getParent()) {
-        blockDoms.insert(&B);
-    }
-
-    for (BasicBlock *pred : predecessors(&BB)) {
-        std::set<BasicBlock*> res;
-        std::set_intersection(
-            blockDoms.begin(), blockDoms.end(),
-            dominators[pred].begin(), dominators[pred].end(),
-            std::inserter(res, res.begin())
-        );
-
-        blockDoms = std::move(res);
-    }
+#define DEBUG_TYPE "dominator-analysis"
+
+STATISTIC(NumBlockVisits, "Number of basic block visits of the dominator analysis");
+STATISTIC(NumIterations, "Number of iterations of the dominator analysis over the loops");
+
+namespace {
+    /**
+        Numbering of the blocks of a function, in layout order, so that the sets of
+        blocks are bit vectors: a set takes one bit per block of the function, and
+        the intersection is a word-wide AND
+    */
+    struct BlockNumbering {
+        std::vector<BasicBlock*> blocks;
+        DenseMap<BasicBlock*, unsigned> index;
+
+        explicit BlockNumbering(Function &F) {
+            for (BasicBlock &BB : F) {
+                index[&BB] = blocks.size();
+                blocks.push_back(&BB);
+            }
+        }
+    };
 
-    blockDoms.insert(&BB);
+    /**
+        Sets of dominators, met by intersection: the entry block starts with none, the
+        blocks whose predecessors were not computed yet with the whole function
+    */
+    struct DominatorLattice {
+        using Element = BitVector;
+        static constexpr MeetOperator meetOperator = MeetOperator::Intersection;
 
-    if (blockDoms != dominators[&BB]) {
-        dominators[&BB] = blockDoms;
-        return true;
-    }
+        const BlockNumbering *numbering;
 
-    return false;
-}
+        Element boundary(BasicBlock &BB) const {
+            return BitVector(numbering->blocks.size());
+        }
 
-bool dominatorAnalysis(Function &F, std::map<BasicBlock*, std::set<BasicBlock*>> &blocksDom) {
-    bool isChanged = false;
+        Element initial(BasicBlock &BB) const {
+            return BitVector(numbering->blocks.size(), true);
+        }
+    };
+
+    /**
+        A block dominates itself: GEN is the block alone, and nothing is killed.
+        GEN is a single vector, moved from the previous block to the visited one
+    */
+    struct DominatorTransfer {
+        const BlockNumbering *numbering;
+        BitVector gen;
+        unsigned last = 0;
+
+        explicit DominatorTransfer(const BlockNumbering &numbering) :
+            numbering(&numbering), gen(numbering.blocks.size()) {}
+
+        const BitVector *getGen(BasicBlock &BB) {
+            gen.reset(last);
+            last = numbering->index.lookup(&BB);
+            gen.set(last);
+
+            return &gen;
+        }
 
-    for (BasicBlock &BB : F) {
-        if (&BB == &F.getEntryBlock()) {
-            if (blocksDom[&BB].empty()) {
-                blocksDom[&BB] = {&BB};
-                isChanged = true;
-            }
-        } else if (getBlockDominators(BB, blocksDom)) {
-            isChanged = true;
+        const BitVector *getKill(BasicBlock &BB) const {
+            return nullptr;
         }
-    }
+    };
 
-    return isChanged;
+    using DominatorSolver = DataflowSolver<DataflowDirection::Forward, DominatorLattice, DominatorTransfer>;
 }
 
-void printIterationInfo(std::map<BasicBlock*, std::set<BasicBlock*>> &blocksDoms, int iteration) {
-    outs() << "Output after iteration " << iteration << "\n\n";
+void printDominators(const BlockNumbering &numbering, const DominatorSolver &solver) {
+    for (BasicBlock *BB : numbering.blocks) {
+        const BitVector *dominators = solver.getResult(BB);
+        if (!dominators) continue;
 
-    for (auto &pair : blocksDoms) {
-        outs() << "Dominators for basic block: " << pair.first->getName() << "\n";
+        outs() << "Dominators for basic block: " << BB->getName() << "\n";
 
-        for (BasicBlock *dom : pair.second) {
-            outs() << dom->getName();
-            outs() << "\n";
+        for (unsigned dom : dominators->set_bits()) {
+            outs() << numbering.blocks[dom]->getName() << "\n";
         }
     }
-
-    outs() << "-------------------\n\n";
 }
 
 PreservedAnalyses DominatorAnalysis::run(Module &M, ModuleAnalysisManager &AM) {
     // Run optimizations on each function in the module
-    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
-        std::map<BasicBlock*, std::set<BasicBlock*>> blocksDoms;
-        int n = 1;
+    for (Function &F : M) {
+        BlockNumbering numbering(F);
+        DominatorSolver solver(F, {&numbering}, DominatorTransfer(numbering));
 
-        while (dominatorAnalysis(*Fiter, blocksDoms)) { printIterationInfo(blocksDoms, n); n++; };
+        unsigned n = solver.solve([&numbering, &solver](unsigned iteration) {
+            outs() << "Output after iteration " << iteration << "\n\n";
+            printDominators(numbering, solver);
+            outs() << "-------------------\n\n";
+        });
+
+        NumBlockVisits += solver.getNumVisits();
+        NumIterations += n;
 
         outs() << "Final output after " << n << " iterations\n\n";
 
-        outs() << "Dominators for function: " << Fiter->getName();
+        outs() << "Dominators for function: " << F.getName();
         outs() << "\n\n";
 
-        for (auto &pair : blocksDoms) {
-            outs() << "Dominators for basic block: " << pair.first->getName();
-            outs() << "\n";
-
-            for (auto &doms : pair.second) {
-                outs() << doms->getName() << "\n";
-            }
-        }
+        printDominators(numbering, solver);
 
         outs() << "------------------\n\n";
     }
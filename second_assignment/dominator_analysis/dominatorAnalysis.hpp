@@ -12,12 +12,17 @@
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/IR/CFG.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/Statistic.h"
+
+#include "../common/dataflowSolver.hpp"
 
 #include <cmath>
 #include <map>
 #include <string>
 #include <algorithm>
 #include <queue>
+#include <vector>
 
 namespace llvm {
     class DominatorAnalysis : public PassInfoMixin<DominatorAnalysis> {
@@ -2,6 +2,11 @@
 
 using namespace llvm;
 
+#define DEBUG_TYPE "reaching-definitions"
+
+STATISTIC(NumBlockVisits, "Number of basic block visits of the reaching definitions analysis");
+STATISTIC(NumIterations, "Number of iterations of the reaching definitions analysis over the loops");
+
 void removeKilled(std::map<StoreInst*, bool> &defsMap, Value *pointer, AliasAnalysis &AA) {
     for (const auto& pair : defsMap) {
         if (AA.alias(pair.first->getPointerOperand(), pointer) != AliasResult::NoAlias) {
@@ -10,68 +15,76 @@ void removeKilled(std::map<StoreInst*, bool> &defsMap, Value *pointer, AliasAnal
     }
 }
 
-bool bbReachingDefs(std::map<BasicBlock*, std::map<StoreInst*, bool>> &reachDefs, BasicBlock &BB, AliasAnalysis &AA) {
-    bool transformed = false;
-
-    std::map<StoreInst*, bool> defsMap;
+namespace {
+    /**
+        Definitions seen so far, each with whether it still reaches the program point
+        (true) or was killed on every path (false). Reaching through one of the paths
+        is enough, so the meet is the union where true wins
+    */
+    struct ReachingDefinitionsLattice {
+        using Element = std::map<StoreInst*, bool>;
+
+        Element boundary(BasicBlock &BB) const {
+            return {};
+        }
 
-    if (reachDefs.find(&BB) == reachDefs.end()) {
-        transformed = true;
-        defsMap = {};
-    } else {
-        defsMap = reachDefs[&BB];
-    }
+        Element initial(BasicBlock &BB) const {
+            return {};
+        }
 
-    for (BasicBlock *pred : predecessors(&BB)) {
-        for (auto &pair : reachDefs[pred]) {
-            if (defsMap.find(pair.first) == defsMap.end() || pair.second == true) {
-                defsMap[pair.first] = pair.second;
-                transformed = true;
+        void meet(Element &result, const Element &other) const {
+            for (auto &pair : other) {
+                if (result.find(pair.first) == result.end() || pair.second == true) {
+                    result[pair.first] = pair.second;
+                }
             }
         }
-    }
-
-    for (Instruction &inst : BB) {
-        if (StoreInst *SI = dyn_cast<StoreInst>(&inst)) {
-            if (defsMap.find(SI) == defsMap.end()) {
-                Value *pointerOperand = SI->getPointerOperand();
-
-                removeKilled(defsMap, pointerOperand, AA);
-                defsMap[SI] = true;
+    };
+
+    /**
+        Every store kills the definitions of the locations it may alias, and
+        becomes a reaching definition
+    */
+    struct ReachingDefinitionsTransfer {
+        AliasAnalysis *AA;
+
+        void operator()(BasicBlock &BB, std::map<StoreInst*, bool> &defsMap) const {
+            for (Instruction &inst : BB) {
+                if (StoreInst *SI = dyn_cast<StoreInst>(&inst)) {
+                    Value *pointerOperand = SI->getPointerOperand();
+
+                    removeKilled(defsMap, pointerOperand, *AA);
+                    defsMap[SI] = true;
+                }
             }
         }
-    }
+    };
 
-    if (transformed) reachDefs[&BB] = defsMap;
-
-    return false;
-}
-
-bool reachingDefinitions(Function &F, std::map<BasicBlock*, std::map<StoreInst*, bool>> &blocksReachDefs, AliasAnalysis &AA) {
-    bool transformed = false;
-
-    for (BasicBlock &BB: F) {
-       if (bbReachingDefs(blocksReachDefs, BB, AA)) transformed = true;
-    }
-
-    return transformed;
+    using ReachingDefinitionsSolver =
+        DataflowSolver<DataflowDirection::Forward, ReachingDefinitionsLattice, ReachingDefinitionsTransfer>;
 }
 
 PreservedAnalyses ReachingDefinitions::run(Module &M, ModuleAnalysisManager &AM) {
     FunctionAnalysisManager &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
 
     // Run optimizations on each function in the module
-    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
-        AliasAnalysis &AA = FAM.getResult<AAManager>(*Fiter);
-        std::map<BasicBlock*, std::map<StoreInst*, bool>> blocksReachDefs;
-        while (reachingDefinitions(*Fiter, blocksReachDefs, AA)) {};
-
-        for (auto &pair : blocksReachDefs) {
-            outs() << "Reaching definitions for basic block: " << pair.first->getName();
-            //pair.first->print(outs());
+    for (Function &F : M) {
+        if (F.isDeclaration()) continue;
+
+        AliasAnalysis &AA = FAM.getResult<AAManager>(F);
+        ReachingDefinitionsSolver solver(F, {}, {&AA});
+
+        NumIterations += solver.solve();
+        NumBlockVisits += solver.getNumVisits();
+
+        for (BasicBlock &BB : F) {
+            const std::map<StoreInst*, bool> *defs = solver.getResult(&BB);
+            if (!defs) continue;
+
+            outs() << "Reaching definitions for basic block: " << BB.getName();
             outs() << "\n";
 
-            for (auto &def : pair.second) {
+            for (auto &def : *defs) {
                 def.first->print(outs());
                 outs() << "\t" << def.second << "\n";
             }
@@ -13,6 +13,9 @@
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/IR/CFG.h"
+#include "llvm/ADT/Statistic.h"
+
+#include "../common/dataflowSolver.hpp"
 
 #include <cmath>
 #include <map>
@@ -4,6 +4,11 @@
 
 using namespace llvm;
 
+#define DEBUG_TYPE "very-busy"
+
+STATISTIC(NumBlockVisits, "Number of basic block visits of the very busy expressions analysis");
+STATISTIC(NumIterations, "Number of iterations of the very busy expressions analysis over the loops");
+
 /**
     Given an operand it returns the pointer to the memory location
     where the operand took its value
@@ -101,121 +106,126 @@ bool areEqual(Instruction &inst1, Instruction &inst2) {
     return false;
 }
 
-/**
-    Computes the intersection between the successors sets
-*/
-std::set<Instruction*> intersectSets(BasicBlock &BB, std::map<BasicBlock*, std::set<Instruction*>> &busyInsts) {
-    std::set<Instruction*> res;
-    bool isFirst = true;
-
-    for (BasicBlock *succ : successors(&BB)) {
-        if (busyInsts.find(succ) == busyInsts.end()) continue;
-
-        if (isFirst) {
-            res = busyInsts[succ];
-            isFirst = false;
-        } else {
-            std::set<Instruction*> temp;
-
-            for (Instruction *rInst : res) {
-                for (Instruction *sInst : busyInsts[succ]) {
-                    if (areEqual(*rInst, *sInst)) temp.insert(rInst);
+namespace {
+    /**
+        Numbering of the expressions of a function: the binary instructions equal to
+        each other (see areEqual) get the same number, so that the sets of expressions
+        are bit vectors and the intersection is a word-wide AND instead of comparing
+        every pair of instructions at every meet.
+
+        Every expression is represented by its first instruction in layout order
+    */
+    struct ExpressionNumbering {
+        std::vector<Instruction*> expressions;
+        DenseMap<Instruction*, unsigned> index;
+
+        explicit ExpressionNumbering(Function &F) {
+            for (Instruction &inst : instructions(F)) {
+                if (!inst.isBinaryOp()) continue;
+
+                auto it = find_if(expressions, [&inst](Instruction *expr) { return areEqual(*expr, inst); });
+
+                if (it != expressions.end()) {
+                    index[&inst] = it - expressions.begin();
+                } else {
+                    index[&inst] = expressions.size();
+                    expressions.push_back(&inst);
                 }
             }
-
-            res = temp;
         }
-    }
-
-    return res;
-}
+    };
 
-/**
-    Removes instructions killed by the given instruction
-*/
-void removeKilled(Instruction &inst, std::set<Instruction*> &blockBusyInsts) {
-    std::vector<Instruction*> instsToRemove;
+    /**
+        Sets of very busy expressions, met by intersection. The exit blocks start
+        with none, the blocks whose successors were not computed yet (the loops
+        with no exit) with all of them, the top of the lattice
+    */
+    struct VeryBusyLattice {
+        using Element = BitVector;
+        static constexpr MeetOperator meetOperator = MeetOperator::Intersection;
 
-    for (Instruction *bInst : blockBusyInsts) {
-        if (bInst->isBinaryOp() && areEqual(inst, *bInst)) instsToRemove.push_back(bInst);
-    }
-
-    for (Instruction *rInst : instsToRemove) {
-        blockBusyInsts.erase(rInst);
-    }
-}
-
-/**
-    Computes the very busy instructions for the given basic block
-*/
-bool getVeryBusyInsts(BasicBlock &BB, std::map<BasicBlock*, std::set<Instruction*>> &busyInsts) {
-    std::set<Instruction*> blockBusyInsts = intersectSets(BB, busyInsts);
-
-    for (Instruction &inst : BB) {
-        removeKilled(inst, blockBusyInsts);
-        if (inst.isBinaryOp()) blockBusyInsts.insert(&inst);
-    }
+        const ExpressionNumbering *numbering;
 
-    if (blockBusyInsts != busyInsts[&BB]) {
-        busyInsts[&BB] = blockBusyInsts;
-
-        return true;
-    }
+        Element boundary(BasicBlock &BB) const {
+            return BitVector(numbering->expressions.size());
+        }
 
-    return false;
-}
+        Element initial(BasicBlock &BB) const {
+            return BitVector(numbering->expressions.size(), true);
+        }
+    };
+
+    /**
+        Computes the very busy instructions for the given basic block: every binary
+        instruction makes its expression very busy (GEN), and nothing is killed.
+        GEN is a single vector, cleared of the bits of the previous block
+    */
+    struct VeryBusyTransfer {
+        const ExpressionNumbering *numbering;
+        BitVector gen;
+        SmallVector<unsigned, 8> generated;
+
+        explicit VeryBusyTransfer(const ExpressionNumbering &numbering) :
+            numbering(&numbering), gen(numbering.expressions.size()) {}
+
+        const BitVector *getGen(BasicBlock &BB) {
+            for (unsigned expr : generated) gen.reset(expr);
+            generated.clear();
+
+            for (Instruction &inst : BB) {
+                if (!inst.isBinaryOp()) continue;
+
+                unsigned expr = numbering->index.lookup(&inst);
+                gen.set(expr);
+                generated.push_back(expr);
+            }
 
-/**
-    Computes very busy expressions for the given function
-*/
-bool veryBusyExpressions(Function &F,  std::map<BasicBlock*, std::set<Instruction*>> &busyInsts) {
-    bool isChanged = false;
+            return &gen;
+        }
 
-    for (BasicBlock &BB : reverse(F)) {
-        //if (BB == F.)
-        if (getVeryBusyInsts(BB, busyInsts)) isChanged = true;
-    }
+        const BitVector *getKill(BasicBlock &BB) const {
+            return nullptr;
+        }
+    };
 
-    return isChanged;
+    using VeryBusySolver = DataflowSolver<DataflowDirection::Backward, VeryBusyLattice, VeryBusyTransfer>;
 }
 
-void printIterationInfo(std::map<BasicBlock*, std::set<Instruction*>> &busyInsts, int iteration) {
-    outs() << "Output after iteration " << iteration << "\n\n";
+void printVeryBusyInsts(Function &F, const ExpressionNumbering &numbering, const VeryBusySolver &solver, StringRef header) {
+    for (BasicBlock &BB : F) {
+        const BitVector *busyInsts = solver.getResult(&BB);
+        if (!busyInsts) continue;
 
-    for (auto &pair : busyInsts) {
-        outs() << "Very busy expressions for basic block: " << pair.first->getName() << "\n";
+        outs() << header << BB.getName() << "\n";
 
-        for (auto &busy : pair.second) {
-            busy->print(outs());
+        for (unsigned busy : busyInsts->set_bits()) {
+            numbering.expressions[busy]->print(outs());
             outs() << "\n";
         }
     }
-
-    outs() << "-------------------\n\n";
 }
 
 PreservedAnalyses VeryBusyExpressions::run(Module &M, ModuleAnalysisManager &AM) {
     // Run optimizations on each function in the module
-    for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
-        std::map<BasicBlock*, std::set<Instruction*>> busyInsts;
-        int n = 1;
+    for (Function &F : M) {
+        ExpressionNumbering numbering(F);
+        VeryBusySolver solver(F, {&numbering}, VeryBusyTransfer(numbering));
+
+        unsigned n = solver.solve([&F, &numbering, &solver](unsigned iteration) {
+            outs() << "Output after iteration " << iteration << "\n\n";
+            printVeryBusyInsts(F, numbering, solver, "Very busy expressions for basic block: ");
+            outs() << "-------------------\n\n";
+        });
 
-        while (veryBusyExpressions(*Fiter, busyInsts)) { printIterationInfo(busyInsts, n); n++;};
+        NumBlockVisits += solver.getNumVisits();
+        NumIterations += n;
 
         outs() << "Final output after " << n << " iterations\n\n";
 
-        outs() << "Dominators for function: " << Fiter->getName();
+        outs() << "Dominators for function: " << F.getName();
         outs() << "\n\n";
 
-        for (auto &pair : busyInsts) {
-            outs() << "Very Busy Expressions for basic block: " << pair.first->getName();
-            outs() << "\n";
-
-            for (auto &busy : pair.second) {
-                busy->print(outs());
-                outs() << "\n";
-            }
-        }
+        printVeryBusyInsts(F, numbering, solver, "Very Busy Expressions for basic block: ");
 
         outs() << "------------------\n\n";
     }
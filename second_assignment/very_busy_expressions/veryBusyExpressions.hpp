@@ -8,8 +8,14 @@
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/Analysis/MemorySSA.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/Statistic.h"
+
+#include "../common/dataflowSolver.hpp"
 
 #include <map>
+#include <vector>
 
 namespace llvm {
     class VeryBusyExpressions : public PassInfoMixin<VeryBusyExpressions> {